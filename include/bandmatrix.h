@@ -0,0 +1,234 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TBandMatrix_H__
+#define __TBandMatrix_H__
+
+#include "tmatrix.h"
+
+// Ленточная матрица -
+// квадратная матрица порядка n, у которой ненулевыми могут быть только
+// элементы a[i][j] с i - kl <= j <= i + ku (kl поддиагоналей, ku наддиагоналей).
+// Хранится построчно по kl + ku + 1 элементов: a[i][j] лежит в позиции
+// i * (kl + ku + 1) + (j - i + kl); ячейки за пределами матрицы не используются
+template<typename T, typename Alloc = TAlignedAllocator<T>>
+class TBandMatrix : private TDynamicVector<T, Alloc, 0>
+{
+  using TDynamicVector<T, Alloc, 0>::pMem;
+
+  size_t dim, kl, ku;
+
+  static size_t CheckedSize(size_t s, size_t l, size_t u)
+  {
+    if (s == 0)
+      throw out_of_range("Matrix size should be greater than zero");
+    if (l >= s || u >= s)
+      throw out_of_range("Bandwidth should be less than matrix size");
+    if (l + u + 1 > MAX_MATRIX_ELEMENTS / s)
+      throw out_of_range("Matrix size should not exceed MAX_MATRIX_ELEMENTS");
+    return s * (l + u + 1);
+  }
+
+  size_t Width() const noexcept { return kl + ku + 1; }
+  bool InBand(size_t i, size_t j) const noexcept { return j + kl >= i && j <= i + ku; }
+
+  TBandMatrix(TDynamicVector<T, Alloc, 0>&& v, size_t s, size_t l, size_t u)
+    : TDynamicVector<T, Alloc, 0>(std::move(v)), dim(s), kl(l), ku(u) {}
+
+  // прямой и обратный ход по готовому LU-разложению lu (та же укладка)
+  static void SolveLU(const T* lu, size_t n, size_t l, size_t u, T* x)
+  {
+    const size_t w = l + u + 1;
+    for (size_t i = 1; i < n; i++)
+    {
+      const T* row = lu + i * w + l - i;
+      T sum = x[i];
+      for (size_t j = (i > l ? i - l : 0); j < i; j++)
+        sum -= row[j] * x[j];
+      x[i] = sum;
+    }
+    for (size_t i = n; i-- > 0;)
+    {
+      const T* row = lu + i * w + l - i;
+      T sum = x[i];
+      for (size_t j = i + 1; j <= min(n - 1, i + u); j++)
+        sum -= row[j] * x[j];
+      x[i] = sum / row[i];
+    }
+  }
+public:
+  TBandMatrix(size_t s = 1, size_t l = 0, size_t u = 0)
+    : TDynamicVector<T, Alloc, 0>(CheckedSize(s, l, u)), dim(s), kl(l), ku(u)
+  {
+  }
+
+  size_t size() const noexcept { return dim; }
+  size_t lower() const noexcept { return kl; }
+  size_t upper() const noexcept { return ku; }
+
+  // индексация: m[i][j] допустима только внутри ленты, без контроля
+  T* operator[](size_t ind)
+  {
+    return pMem + ind * Width() + kl - ind;
+  }
+  const T* operator[](size_t ind) const
+  {
+    return pMem + ind * Width() + kl - ind;
+  }
+  // индексация с контролем; элементы вне ленты не хранятся
+  T& at(size_t i, size_t j)
+  {
+    if (i >= dim || j >= dim || !InBand(i, j))
+      throw out_of_range("Matrix index is out of range");
+    return (*this)[i][j];
+  }
+  const T& at(size_t i, size_t j) const
+  {
+    if (i >= dim || j >= dim || !InBand(i, j))
+      throw out_of_range("Matrix index is out of range");
+    return (*this)[i][j];
+  }
+
+  TDynamicMatrix<T> dense() const
+  {
+    TDynamicMatrix<T> res(dim);
+    for (size_t i = 0; i < dim; i++)
+      for (size_t j = (i > kl ? i - kl : 0); j <= min(dim - 1, i + ku); j++)
+        res[i][j] = (*this)[i][j];
+    return res;
+  }
+
+  // сравнение
+  bool operator==(const TBandMatrix& m) const noexcept
+  {
+    if (dim != m.dim || kl != m.kl || ku != m.ku)
+      return false;
+    for (size_t i = 0; i < dim; i++)
+      for (size_t j = (i > kl ? i - kl : 0); j <= min(dim - 1, i + ku); j++)
+        if (!((*this)[i][j] == m[i][j]))
+          return false;
+    return true;
+  }
+  bool operator!=(const TBandMatrix& m) const noexcept
+  {
+    return !(*this == m);
+  }
+
+  // матрично-скалярные операции
+  TBandMatrix operator*(const T& val) const
+  {
+    return TBandMatrix(TDynamicVector<T, Alloc, 0>::operator*(val), dim, kl, ku);
+  }
+
+  // матрично-векторные операции: O(n * (kl + ku + 1))
+  TDynamicVector<T> operator*(TVectorView<const T> v) const
+  {
+    if (dim != v.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    TDynamicVector<T> res(dim, NO_INIT);
+    for (size_t i = 0; i < dim; i++)
+    {
+      const T* row = (*this)[i];
+      T sum = T();
+      for (size_t j = (i > kl ? i - kl : 0); j <= min(dim - 1, i + ku); j++)
+        sum += row[j] * v[j];
+      res[i] = sum;
+    }
+    return res;
+  }
+
+  // матрично-матричные операции (ленты должны совпадать)
+  TBandMatrix operator+(const TBandMatrix& m) const
+  {
+    if (dim != m.dim || kl != m.kl || ku != m.ku)
+      throw length_error("Matrices should have equal sizes and bandwidths");
+    return TBandMatrix(TDynamicVector<T, Alloc, 0>::operator+(m), dim, kl, ku);
+  }
+  TBandMatrix operator-(const TBandMatrix& m) const
+  {
+    if (dim != m.dim || kl != m.kl || ku != m.ku)
+      throw length_error("Matrices should have equal sizes and bandwidths");
+    return TBandMatrix(TDynamicVector<T, Alloc, 0>::operator-(m), dim, kl, ku);
+  }
+
+  // решение системы A x = b.
+  // LU-разложение без выбора ведущего элемента сохраняет ленту и требует
+  // O(n * kl * ku) операций; для трехдиагональной матрицы - метод прогонки.
+  // Подходит для матриц с диагональным преобладанием; при нулевом ведущем
+  // элементе выбрасывается исключение
+  TDynamicVector<T> solve(TVectorView<const T> b) const
+  {
+    if (dim != b.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    TDynamicVector<T> x(dim, NO_INIT);
+    for (size_t i = 0; i < dim; i++)
+      x[i] = b[i];
+    if (kl == 1 && ku == 1)
+    {
+      // прогонка: c'[i] = c[i] / (b[i] - a[i] c'[i-1])
+      TDynamicVector<T> c(dim, NO_INIT);
+      const T* row = (*this)[0];
+      T denom = row[0];
+      for (size_t i = 0; i < dim; i++)
+      {
+        row = (*this)[i];
+        if (i > 0)
+        {
+          denom = row[i] - row[i - 1] * c[i - 1];
+          x[i] -= row[i - 1] * x[i - 1];
+        }
+        if (denom == T())
+          throw runtime_error("Zero pivot in band solver");
+        if (i + 1 < dim)
+          c[i] = row[i + 1] / denom;
+        x[i] = x[i] / denom;
+      }
+      for (size_t i = dim - 1; i-- > 0;)
+        x[i] -= c[i] * x[i + 1];
+      return x;
+    }
+
+    TDynamicVector<T, Alloc, 0> lu(*this);
+    const size_t w = Width();
+    for (size_t k = 0; k < dim; k++)
+    {
+      const T* prow = lu.data() + k * w + kl - k;
+      if (prow[k] == T())
+        throw runtime_error("Zero pivot in band solver");
+      for (size_t i = k + 1; i <= min(dim - 1, k + kl); i++)
+      {
+        T* row = lu.data() + i * w + kl - i;
+        const T l = row[k] / prow[k];
+        row[k] = l;
+        for (size_t j = k + 1; j <= min(dim - 1, k + ku); j++)
+          row[j] -= l * prow[j];
+      }
+    }
+    SolveLU(lu.data(), dim, kl, ku, x.data());
+    return x;
+  }
+
+  // ввод/вывод: вводятся элементы ленты построчно, выводится полная матрица
+  friend istream& operator>>(istream& istr, TBandMatrix& v)
+  {
+    for (size_t i = 0; i < v.dim; i++)
+      for (size_t j = (i > v.kl ? i - v.kl : 0); j <= min(v.dim - 1, i + v.ku); j++)
+        istr >> v[i][j]; // требуется оператор>> для типа T
+    return istr;
+  }
+  friend ostream& operator<<(ostream& ostr, const TBandMatrix& v)
+  {
+    for (size_t i = 0; i < v.dim; i++)
+    {
+      for (size_t j = 0; j < v.dim; j++)
+        ostr << (v.InBand(i, j) ? v[i][j] : T()) << ' '; // требуется оператор<< для типа T
+      ostr << endl;
+    }
+    return ostr;
+  }
+};
+
+#endif
@@ -0,0 +1,365 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TBlockSparseMatrix_H__
+#define __TBlockSparseMatrix_H__
+
+#include <vector>
+#include "spmatrix.h"
+
+// Блочно-разреженная матрица в формате BSR -
+// матрица разбита на плотные блоки B x B, хранятся только ненулевые блоки.
+// Блоки блочной строки I занимают позиции [blockPtr[I], blockPtr[I + 1]),
+// блок k стоит в блочном столбце blockCol[k], его элементы лежат по столбцам
+// в values[k * B * B ...]. Крайние блоки дополняются нулями до B x B
+
+// Ядра блочной строки над регистрами V; размер блока известен при
+// компиляции, циклы по блоку разворачиваются
+template<typename V, typename T, size_t B>
+struct TBsrKernel
+{
+  // y = A * x: столбец j блока складывается с весом x[j], сумма блочной
+  // строки живет в B / width регистрах. x дополнен нулями до целого
+  // числа блоков, y - тоже
+  MP2_KERNEL(V) static void Vector(size_t nbrows, const size_t* ptr, const size_t* col, const T* val, const T* x, T* y)
+  {
+    static_assert(B % V::width == 0, "Block size should be a multiple of register width");
+    constexpr size_t nv = B / V::width;
+    for (size_t bi = 0; bi < nbrows; bi++)
+    {
+      typename V::reg acc[nv];
+      for (size_t r = 0; r < nv; r++)
+        acc[r] = V::zero();
+      for (size_t k = ptr[bi]; k < ptr[bi + 1]; k++)
+      {
+        const T* a = val + k * B * B;
+        const T* xb = x + col[k] * B;
+        for (size_t j = 0; j < B; j++)
+        {
+          const typename V::reg xj = V::set1(xb[j]);
+          for (size_t r = 0; r < nv; r++)
+            acc[r] = V::fma(V::load(a + j * B + r * V::width), xj, acc[r]);
+        }
+      }
+      for (size_t r = 0; r < nv; r++)
+        V::store(y + bi * B + r * V::width, acc[r]);
+    }
+  }
+  // c (B x n) += A * x (B x n), строки c и x идут с шагом n
+  MP2_KERNEL(V) static void Block(const T* a, const T* x, T* c, size_t n)
+  {
+    size_t l = 0;
+    for (; l + V::width <= n; l += V::width)
+    {
+      typename V::reg xv[B];
+      for (size_t j = 0; j < B; j++)
+        xv[j] = V::load(x + j * n + l);
+      for (size_t i = 0; i < B; i++)
+      {
+        typename V::reg acc = V::load(c + i * n + l);
+        for (size_t j = 0; j < B; j++)
+          acc = V::fma(V::set1(a[j * B + i]), xv[j], acc);
+        V::store(c + i * n + l, acc);
+      }
+    }
+    for (; l < n; l++)
+      for (size_t i = 0; i < B; i++)
+      {
+        T sum = c[i * n + l];
+        for (size_t j = 0; j < B; j++)
+          sum += a[j * B + i] * x[j * n + l];
+        c[i * n + l] = sum;
+      }
+  }
+  // C += A * X по блочным строкам. Неполные последние блочные строки
+  // X и C берутся из буферов xtail и ctail (B x n, дополнены нулями)
+  MP2_KERNEL(V) static void Matrix(size_t nbrows, size_t nbcols, const size_t* ptr, const size_t* col, const T* val,
+    const T* x, const T* xtail, bool xfull, T* c, T* ctail, bool cfull, size_t n)
+  {
+    for (size_t bi = 0; bi < nbrows; bi++)
+    {
+      T* cb = bi + 1 < nbrows || cfull ? c + bi * B * n : ctail;
+      for (size_t k = ptr[bi]; k < ptr[bi + 1]; k++)
+      {
+        const T* xb = col[k] + 1 < nbcols || xfull ? x + col[k] * B * n : xtail;
+        Block(val + k * B * B, xb, cb, n);
+      }
+    }
+  }
+};
+
+#ifdef MP2_SIMD_X86
+// входы уровней; для умножения на вектор размер блока должен делиться
+// на ширину регистра
+template<typename T, size_t B>
+struct TBsrEntry
+{
+  template<typename V>
+  static constexpr bool fitsVector = V::hasMul && B % V::width == 0;
+
+  MP2_SIMD_ENTRY("sse2") static void Sse2Vector(size_t nbrows, const size_t* ptr, const size_t* col, const T* val, const T* x, T* y)
+  {
+    if constexpr (fitsVector<TSse2<T>>)
+      TBsrKernel<TSse2<T>, T, B>::Vector(nbrows, ptr, col, val, x, y);
+  }
+  MP2_SIMD_ENTRY("avx2,fma") static void Avx2Vector(size_t nbrows, const size_t* ptr, const size_t* col, const T* val, const T* x, T* y)
+  {
+    if constexpr (fitsVector<TAvx2<T>>)
+      TBsrKernel<TAvx2<T>, T, B>::Vector(nbrows, ptr, col, val, x, y);
+  }
+  MP2_SIMD_ENTRY("avx512f,avx512dq") static void Avx512Vector(size_t nbrows, const size_t* ptr, const size_t* col, const T* val, const T* x, T* y)
+  {
+    if constexpr (fitsVector<TAvx512<T>>)
+      TBsrKernel<TAvx512<T>, T, B>::Vector(nbrows, ptr, col, val, x, y);
+  }
+  MP2_SIMD_ENTRY("sse2") static void Sse2Matrix(size_t nbrows, size_t nbcols, const size_t* ptr, const size_t* col, const T* val,
+    const T* x, const T* xtail, bool xfull, T* c, T* ctail, bool cfull, size_t n)
+  {
+    if constexpr (TSse2<T>::hasMul)
+      TBsrKernel<TSse2<T>, T, B>::Matrix(nbrows, nbcols, ptr, col, val, x, xtail, xfull, c, ctail, cfull, n);
+  }
+  MP2_SIMD_ENTRY("avx2,fma") static void Avx2Matrix(size_t nbrows, size_t nbcols, const size_t* ptr, const size_t* col, const T* val,
+    const T* x, const T* xtail, bool xfull, T* c, T* ctail, bool cfull, size_t n)
+  {
+    if constexpr (TAvx2<T>::hasMul)
+      TBsrKernel<TAvx2<T>, T, B>::Matrix(nbrows, nbcols, ptr, col, val, x, xtail, xfull, c, ctail, cfull, n);
+  }
+  MP2_SIMD_ENTRY("avx512f,avx512dq") static void Avx512Matrix(size_t nbrows, size_t nbcols, const size_t* ptr, const size_t* col, const T* val,
+    const T* x, const T* xtail, bool xfull, T* c, T* ctail, bool cfull, size_t n)
+  {
+    if constexpr (TAvx512<T>::hasMul)
+      TBsrKernel<TAvx512<T>, T, B>::Matrix(nbrows, nbcols, ptr, col, val, x, xtail, xfull, c, ctail, cfull, n);
+  }
+};
+#endif
+
+template<typename T, size_t B = 4>
+class TBlockSparseMatrix
+{
+  static_assert(B > 0, "Block size should be positive");
+
+  size_t nrows, ncols;
+  size_t nbrows, nbcols;
+  vector<size_t> blockPtr;
+  vector<size_t> blockCol;
+  vector<T> values;
+
+  static void CheckSize(size_t r, size_t c)
+  {
+    if (r == 0 || c == 0)
+      throw out_of_range("Matrix size should be greater than zero");
+    if (r > MAX_VECTOR_SIZE || c > MAX_VECTOR_SIZE)
+      throw out_of_range("Matrix size should not exceed MAX_VECTOR_SIZE");
+  }
+
+  // выбирается самый широкий уровень, регистр которого укладывается в блок
+  void MultiplyVector(const T* x, T* y) const
+  {
+#ifdef MP2_SIMD_X86
+    if constexpr (TIsSimdType<T>::value)
+    {
+      using E = TBsrEntry<T, B>;
+      const TSimdLevel level = simd_level();
+      if (level >= SIMD_AVX512 && E::template fitsVector<TAvx512<T>>)
+        return E::Avx512Vector(nbrows, blockPtr.data(), blockCol.data(), values.data(), x, y);
+      if (level >= SIMD_AVX2 && E::template fitsVector<TAvx2<T>>)
+        return E::Avx2Vector(nbrows, blockPtr.data(), blockCol.data(), values.data(), x, y);
+      if (level >= SIMD_SSE2 && E::template fitsVector<TSse2<T>>)
+        return E::Sse2Vector(nbrows, blockPtr.data(), blockCol.data(), values.data(), x, y);
+    }
+#endif
+    TBsrKernel<TScalarReg<T>, T, B>::Vector(nbrows, blockPtr.data(), blockCol.data(), values.data(), x, y);
+  }
+  void MultiplyMatrix(const T* x, const T* xtail, bool xfull, T* c, T* ctail, bool cfull, size_t n) const
+  {
+#ifdef MP2_SIMD_X86
+    if constexpr (TIsSimdType<T>::value)
+    {
+      using E = TBsrEntry<T, B>;
+      const TSimdLevel level = simd_level();
+      if (level >= SIMD_AVX512 && TAvx512<T>::hasMul)
+        return E::Avx512Matrix(nbrows, nbcols, blockPtr.data(), blockCol.data(), values.data(), x, xtail, xfull, c, ctail, cfull, n);
+      if (level >= SIMD_AVX2 && TAvx2<T>::hasMul)
+        return E::Avx2Matrix(nbrows, nbcols, blockPtr.data(), blockCol.data(), values.data(), x, xtail, xfull, c, ctail, cfull, n);
+      if (level >= SIMD_SSE2 && TSse2<T>::hasMul)
+        return E::Sse2Matrix(nbrows, nbcols, blockPtr.data(), blockCol.data(), values.data(), x, xtail, xfull, c, ctail, cfull, n);
+    }
+#endif
+    TBsrKernel<TScalarReg<T>, T, B>::Matrix(nbrows, nbcols, blockPtr.data(), blockCol.data(), values.data(),
+      x, xtail, xfull, c, ctail, cfull, n);
+  }
+public:
+  TBlockSparseMatrix(size_t r = B, size_t c = B)
+    : nrows(r), ncols(c), nbrows((r + B - 1) / B), nbcols((c + B - 1) / B)
+  {
+    CheckSize(r, c);
+    blockPtr.assign(nbrows + 1, 0);
+  }
+  // построение по списку (i, j, value); повторяющиеся позиции суммируются
+  TBlockSparseMatrix(size_t r, size_t c, const vector<TTriplet<T>>& t)
+    : nrows(r), ncols(c), nbrows((r + B - 1) / B), nbcols((c + B - 1) / B)
+  {
+    CheckSize(r, c);
+    for (const TTriplet<T>& e : t)
+      if (e.row >= r || e.col >= c)
+        throw out_of_range("Matrix index is out of range");
+    vector<size_t> order(t.size());
+    for (size_t k = 0; k < t.size(); k++)
+      order[k] = k;
+    sort(order.begin(), order.end(), [&t](size_t a, size_t b)
+    {
+      if (t[a].row / B != t[b].row / B)
+        return t[a].row / B < t[b].row / B;
+      return t[a].col / B < t[b].col / B;
+    });
+
+    blockPtr.assign(nbrows + 1, 0);
+    for (size_t k = 0; k < order.size(); k++)
+    {
+      const TTriplet<T>& e = t[order[k]];
+      const size_t bi = e.row / B, bj = e.col / B;
+      if (k == 0 || t[order[k - 1]].row / B != bi || t[order[k - 1]].col / B != bj)
+      {
+        blockCol.push_back(bj);
+        values.resize(values.size() + B * B, T());
+        blockPtr[bi + 1]++;
+      }
+      values[values.size() - B * B + (e.col % B) * B + e.row % B] += e.val;
+    }
+    for (size_t i = 0; i < nbrows; i++)
+      blockPtr[i + 1] += blockPtr[i];
+  }
+  // из плотной матрицы: сохраняются блоки, содержащие ненулевые элементы
+  explicit TBlockSparseMatrix(const TDynamicMatrix<T>& m)
+    : nrows(m.rows()), ncols(m.cols()), nbrows((m.rows() + B - 1) / B), nbcols((m.cols() + B - 1) / B)
+  {
+    blockPtr.assign(nbrows + 1, 0);
+    for (size_t bi = 0; bi < nbrows; bi++)
+    {
+      const size_t ilast = min(nrows, (bi + 1) * B);
+      for (size_t bj = 0; bj < nbcols; bj++)
+      {
+        const size_t jlast = min(ncols, (bj + 1) * B);
+        bool nonzero = false;
+        for (size_t i = bi * B; i < ilast && !nonzero; i++)
+          for (size_t j = bj * B; j < jlast && !nonzero; j++)
+            nonzero = !(m[i][j] == T());
+        if (!nonzero)
+          continue;
+        blockCol.push_back(bj);
+        values.resize(values.size() + B * B, T());
+        T* blk = values.data() + values.size() - B * B;
+        for (size_t i = bi * B; i < ilast; i++)
+          for (size_t j = bj * B; j < jlast; j++)
+            blk[(j % B) * B + i % B] = m[i][j];
+      }
+      blockPtr[bi + 1] = blockCol.size();
+    }
+  }
+
+  size_t rows() const noexcept { return nrows; }
+  size_t cols() const noexcept { return ncols; }
+  // число хранимых блоков
+  size_t blocks() const noexcept { return blockCol.size(); }
+
+  // доступ к элементу с контролем; вне хранимых блоков - T()
+  T at(size_t i, size_t j) const
+  {
+    if (i >= nrows || j >= ncols)
+      throw out_of_range("Matrix index is out of range");
+    const size_t bi = i / B;
+    auto first = blockCol.begin() + blockPtr[bi], last = blockCol.begin() + blockPtr[bi + 1];
+    auto it = lower_bound(first, last, j / B);
+    if (it == last || *it != j / B)
+      return T();
+    return values[(it - blockCol.begin()) * B * B + (j % B) * B + i % B];
+  }
+
+  TDynamicMatrix<T> dense() const
+  {
+    TDynamicMatrix<T> res(nrows, ncols);
+    for (size_t bi = 0; bi < nbrows; bi++)
+      for (size_t k = blockPtr[bi]; k < blockPtr[bi + 1]; k++)
+      {
+        const T* blk = values.data() + k * B * B;
+        for (size_t i = bi * B; i < min(nrows, (bi + 1) * B); i++)
+          for (size_t j = blockCol[k] * B; j < min(ncols, (blockCol[k] + 1) * B); j++)
+            res[i][j] = blk[(j % B) * B + i % B];
+      }
+    return res;
+  }
+
+  // сравнение (по хранимой структуре)
+  bool operator==(const TBlockSparseMatrix& m) const noexcept
+  {
+    return nrows == m.nrows && ncols == m.ncols && blockPtr == m.blockPtr &&
+      blockCol == m.blockCol && values == m.values;
+  }
+  bool operator!=(const TBlockSparseMatrix& m) const noexcept
+  {
+    return !(*this == m);
+  }
+
+  // матрично-скалярные операции
+  TBlockSparseMatrix operator*(const T& val) const
+  {
+    TBlockSparseMatrix res(*this);
+    for (T& x : res.values)
+      x *= val;
+    return res;
+  }
+
+  // матрично-векторные операции
+  TDynamicVector<T> operator*(TVectorView<const T> v) const
+  {
+    if (ncols != v.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    // x, дополненный нулями до целого числа блоков
+    vector<T> x(nbcols * B, T());
+    for (size_t j = 0; j < ncols; j++)
+      x[j] = v[j];
+
+    vector<T> y(nbrows * B);
+    MultiplyVector(x.data(), y.data());
+
+    TDynamicVector<T> res(nrows, NO_INIT);
+    for (size_t i = 0; i < nrows; i++)
+      res[i] = y[i];
+    return res;
+  }
+
+  // матрично-матричные операции: блок A умножается на B строк m,
+  // неполная последняя блочная строка дополняется нулями
+  TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& m) const
+  {
+    if (ncols != m.rows())
+      throw length_error("Matrix sizes should be compatible");
+    const size_t n = m.cols();
+    const bool xfull = ncols % B == 0, cfull = nrows % B == 0;
+    vector<T> xtail(xfull ? 0 : B * n, T()), ctail(cfull ? 0 : B * n, T());
+    if (!xfull)
+      copy(m.data() + (nbcols - 1) * B * n, m.data() + ncols * n, xtail.begin());
+
+    TDynamicMatrix<T> res(nrows, n);
+    MultiplyMatrix(m.data(), xtail.data(), xfull, res.data(), ctail.data(), cfull, n);
+    if (!cfull)
+      copy(ctail.begin(), ctail.begin() + (nrows - (nbrows - 1) * B) * n, res.data() + (nbrows - 1) * B * n);
+    return res;
+  }
+
+  // вывод: по строке "i j value" на каждый элемент хранимых блоков
+  friend ostream& operator<<(ostream& ostr, const TBlockSparseMatrix& m)
+  {
+    for (size_t bi = 0; bi < m.nbrows; bi++)
+      for (size_t i = bi * B; i < min(m.nrows, (bi + 1) * B); i++)
+        for (size_t k = m.blockPtr[bi]; k < m.blockPtr[bi + 1]; k++)
+          for (size_t j = m.blockCol[k] * B; j < min(m.ncols, (m.blockCol[k] + 1) * B); j++)
+            ostr << i << ' ' << j << ' ' << m.values[k * B * B + (j % B) * B + i % B] << endl;
+    return ostr;
+  }
+};
+
+#endif
@@ -0,0 +1,171 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TDiagonalMatrix_H__
+#define __TDiagonalMatrix_H__
+
+#include "tmatrix.h"
+
+// Диагональная матрица -
+// хранит только n диагональных элементов. Умножение на вектор стоит O(n),
+// на плотную матрицу (масштабирование строк или столбцов) - O(n^2)
+template<typename T, typename Alloc = TAlignedAllocator<T>>
+class TDiagonalMatrix : private TDynamicVector<T, Alloc, 0>
+{
+  using TDynamicVector<T, Alloc, 0>::pMem;
+  using TDynamicVector<T, Alloc, 0>::sz;
+
+  static size_t CheckedSize(size_t s)
+  {
+    if (s == 0)
+      throw out_of_range("Matrix size should be greater than zero");
+    if (s > MAX_VECTOR_SIZE)
+      throw out_of_range("Matrix size should not exceed MAX_VECTOR_SIZE");
+    return s;
+  }
+
+  TDiagonalMatrix(TDynamicVector<T, Alloc, 0>&& v) : TDynamicVector<T, Alloc, 0>(std::move(v)) {}
+public:
+  TDiagonalMatrix(size_t s = 1) : TDynamicVector<T, Alloc, 0>(CheckedSize(s))
+  {
+  }
+  // из вектора диагональных элементов
+  explicit TDiagonalMatrix(TVectorView<const T> d) : TDynamicVector<T, Alloc, 0>(CheckedSize(d.size()), NO_INIT)
+  {
+    for (size_t i = 0; i < sz; i++)
+      pMem[i] = d[i];
+  }
+
+  using TDynamicVector<T, Alloc, 0>::size;
+
+  // индексация: i-й диагональный элемент
+  using TDynamicVector<T, Alloc, 0>::operator[];
+  using TDynamicVector<T, Alloc, 0>::at;
+  // элемент (i, j) с контролем; вне диагонали - T()
+  T at(size_t i, size_t j) const
+  {
+    if (i >= sz || j >= sz)
+      throw out_of_range("Matrix index is out of range");
+    return i == j ? pMem[i] : T();
+  }
+
+  TDynamicMatrix<T> dense() const
+  {
+    TDynamicMatrix<T> res(sz);
+    for (size_t i = 0; i < sz; i++)
+      res[i][i] = pMem[i];
+    return res;
+  }
+
+  // сравнение
+  bool operator==(const TDiagonalMatrix& m) const noexcept
+  {
+    return TDynamicVector<T, Alloc, 0>::operator==(m);
+  }
+  bool operator!=(const TDiagonalMatrix& m) const noexcept
+  {
+    return !(*this == m);
+  }
+
+  // матрично-скалярные операции
+  TDiagonalMatrix operator*(const T& val) const
+  {
+    return TDiagonalMatrix(TDynamicVector<T, Alloc, 0>::operator*(val));
+  }
+
+  // матрично-векторные операции: O(n)
+  TDynamicVector<T> operator*(TVectorView<const T> v) const
+  {
+    if (sz != v.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    TDynamicVector<T> res(sz, NO_INIT);
+    for (size_t i = 0; i < sz; i++)
+      res[i] = pMem[i] * v[i];
+    return res;
+  }
+
+  // матрично-матричные операции
+  TDiagonalMatrix operator+(const TDiagonalMatrix& m) const
+  {
+    if (sz != m.sz)
+      throw length_error("Matrices should have equal sizes");
+    return TDiagonalMatrix(TDynamicVector<T, Alloc, 0>::operator+(m));
+  }
+  TDiagonalMatrix operator-(const TDiagonalMatrix& m) const
+  {
+    if (sz != m.sz)
+      throw length_error("Matrices should have equal sizes");
+    return TDiagonalMatrix(TDynamicVector<T, Alloc, 0>::operator-(m));
+  }
+  TDiagonalMatrix operator*(const TDiagonalMatrix& m) const
+  {
+    if (sz != m.sz)
+      throw length_error("Matrices should have equal sizes");
+    TDiagonalMatrix res(TDynamicVector<T, Alloc, 0>(sz, NO_INIT));
+    for (size_t i = 0; i < sz; i++)
+      res.pMem[i] = pMem[i] * m.pMem[i];
+    return res;
+  }
+  // D * M - масштабирование строк M: O(n * cols)
+  TDynamicMatrix<T> operator*(TMatrixView<const T> m) const
+  {
+    if (sz != m.rows())
+      throw length_error("Matrix sizes should be compatible");
+    TDynamicMatrix<T> res(m.rows(), m.cols(), NO_INIT);
+    for (size_t i = 0; i < m.rows(); i++)
+    {
+      const T d = pMem[i];
+      const T* row = m[i];
+      T* rrow = res[i];
+      for (size_t j = 0; j < m.cols(); j++)
+        rrow[j] = d * row[j];
+    }
+    return res;
+  }
+
+  // ввод/вывод: вводятся диагональные элементы, выводится полная матрица
+  friend istream& operator>>(istream& istr, TDiagonalMatrix& v)
+  {
+    for (size_t i = 0; i < v.sz; i++)
+      istr >> v.pMem[i]; // требуется оператор>> для типа T
+    return istr;
+  }
+  friend ostream& operator<<(ostream& ostr, const TDiagonalMatrix& v)
+  {
+    for (size_t i = 0; i < v.sz; i++)
+    {
+      for (size_t j = 0; j < v.sz; j++)
+        ostr << (i == j ? v.pMem[i] : T()) << ' '; // требуется оператор<< для типа T
+      ostr << endl;
+    }
+    return ostr;
+  }
+};
+
+// M * D - масштабирование столбцов M: O(rows * n)
+template<typename U, typename DA>
+TDynamicMatrix<typename remove_const<U>::type> operator*(TMatrixView<U> m,
+  const TDiagonalMatrix<typename remove_const<U>::type, DA>& d)
+{
+  if (m.cols() != d.size())
+    throw length_error("Matrix sizes should be compatible");
+  TDynamicMatrix<typename remove_const<U>::type> res(m.rows(), m.cols(), NO_INIT);
+  for (size_t i = 0; i < m.rows(); i++)
+  {
+    const U* row = m[i];
+    typename remove_const<U>::type* rrow = res[i];
+    for (size_t j = 0; j < m.cols(); j++)
+      rrow[j] = row[j] * d[j];
+  }
+  return res;
+}
+template<typename T, typename A, typename DA>
+TDynamicMatrix<T> operator*(const TDynamicMatrix<T, A>& m, const TDiagonalMatrix<T, DA>& d)
+{
+  return TMatrixView<const T>(m) * d;
+}
+
+#endif
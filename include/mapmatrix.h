@@ -0,0 +1,149 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TMappedMatrix_H__
+#define __TMappedMatrix_H__
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include "tmatrix.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Двоичный формат матрицы для отображения в память:
+// заголовок из 64 байт, затем r * c элементов построчно.
+// Данные начинаются на границе 64 байт от начала (выровненного) отображения
+const char MAPPED_MATRIX_MAGIC[8] = { 'M', 'P', '2', 'M', 'T', 'R', 'X', '\0' };
+
+struct TMappedMatrixHeader
+{
+  char magic[8];
+  uint64_t rows, cols;
+  uint64_t elemSize;
+  uint64_t reserved[4];
+};
+static_assert(sizeof(TMappedMatrixHeader) == 64, "Mapped matrix header should take 64 bytes");
+
+// Режим отображения файла. Файл открывается только для чтения, страницы
+// отображаются частным образом: до первой записи они общие с кэшем файла,
+// записываемая страница копируется. Матрица допускает любые операции,
+// файл при этом не изменяется; READ_ONLY и COPY_ON_WRITE отображают файл
+// одинаково (второе имя - для матриц, которые будут изменяться)
+enum TMapMode { READ_ONLY, COPY_ON_WRITE };
+
+// Удалитель отображенного буфера: снимает отображение файла целиком
+template<typename T>
+struct TUnmapDeleter
+{
+  void* base;
+  size_t len;
+
+  void operator()(T*) const noexcept
+  {
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+#else
+    munmap(base, len);
+#endif
+  }
+};
+
+// запись матрицы в двоичный файл формата отображения
+template<typename T, typename Alloc>
+void save_matrix(const string& path, const TDynamicMatrix<T, Alloc>& m)
+{
+  static_assert(is_trivially_copyable<T>::value, "Mapped matrix requires trivially copyable elements");
+  TMappedMatrixHeader h{};
+  memcpy(h.magic, MAPPED_MATRIX_MAGIC, sizeof(h.magic));
+  h.rows = m.rows();
+  h.cols = m.cols();
+  h.elemSize = sizeof(T);
+  ofstream f(path, ios::binary | ios::trunc);
+  f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  f.write(reinterpret_cast<const char*>(m.data()), streamsize(m.rows() * m.cols() * sizeof(T)));
+  if (!f)
+    throw runtime_error("Cannot write matrix file " + path);
+}
+
+// матрица, элементы которой - страницы отображенного файла.
+// Загрузка не читает данных: страницы подгружаются при первом обращении,
+// поэтому файл может превышать объем памяти. Матрица владеет отображением
+// (см. TAdopt), копия матрицы - обычная матрица в куче
+template<typename T>
+TDynamicMatrix<T> map_matrix(const string& path, TMapMode = READ_ONLY)
+{
+  static_assert(is_trivially_copyable<T>::value, "Mapped matrix requires trivially copyable elements");
+  size_t len = 0;
+  void* base = nullptr;
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    throw runtime_error("Cannot open matrix file " + path);
+  LARGE_INTEGER fsize;
+  HANDLE mapping = nullptr;
+  if (GetFileSizeEx(file, &fsize) && fsize.QuadPart >= LONGLONG(sizeof(TMappedMatrixHeader)))
+  {
+    len = size_t(fsize.QuadPart);
+    mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  }
+  if (mapping != nullptr)
+  {
+    base = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+  }
+  CloseHandle(file);
+  if (base == nullptr)
+    throw runtime_error("Cannot map matrix file " + path);
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw runtime_error("Cannot open matrix file " + path);
+  struct stat st;
+  if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(TMappedMatrixHeader))
+  {
+    len = size_t(st.st_size);
+    base = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+      base = nullptr;
+  }
+  close(fd);
+  if (base == nullptr)
+    throw runtime_error("Cannot map matrix file " + path);
+#endif
+
+  TUnmapDeleter<T> deleter{ base, len };
+  const TMappedMatrixHeader& h = *static_cast<const TMappedMatrixHeader*>(base);
+  try
+  {
+    if (memcmp(h.magic, MAPPED_MATRIX_MAGIC, sizeof(h.magic)) != 0 || h.elemSize != sizeof(T))
+      throw runtime_error("Matrix file " + path + " has wrong format or element type");
+    if (h.rows == 0 || h.cols == 0 || h.cols > (len - sizeof(h)) / sizeof(T) / h.rows)
+      throw runtime_error("Matrix file " + path + " is truncated");
+    T* arr = reinterpret_cast<T*>(static_cast<char*>(base) + sizeof(h));
+    return TDynamicMatrix<T>(arr, size_t(h.rows), size_t(h.cols), ADOPT, deleter);
+  }
+  catch (...)
+  {
+    deleter(nullptr);
+    throw;
+  }
+}
+
+#endif
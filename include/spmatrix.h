@@ -0,0 +1,178 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TSparseMatrix_H__
+#define __TSparseMatrix_H__
+
+#include <vector>
+#include "tmatrix.h"
+
+// Элемент разреженной матрицы в координатной форме (i, j, value)
+template<typename T>
+struct TTriplet
+{
+  size_t row, col;
+  T val;
+};
+
+// Разреженная матрица в формате CSR -
+// ненулевые элементы хранятся построчно: values[k] стоит в столбце colIdx[k],
+// элементы строки i занимают позиции [rowPtr[i], rowPtr[i + 1]).
+// Внутри строки столбцы упорядочены по возрастанию
+template<typename T>
+class TSparseMatrix
+{
+  size_t nrows, ncols;
+  vector<size_t> rowPtr;
+  vector<size_t> colIdx;
+  vector<T> values;
+
+  // проверка размеров до выделения rowPtr; возвращает число строк
+  static size_t CheckedRows(size_t r, size_t c)
+  {
+    if (r == 0 || c == 0)
+      throw out_of_range("Matrix size should be greater than zero");
+    if (r > MAX_VECTOR_SIZE || c > MAX_VECTOR_SIZE)
+      throw out_of_range("Matrix size should not exceed MAX_VECTOR_SIZE");
+    return r;
+  }
+public:
+  TSparseMatrix(size_t r = 1, size_t c = 1) : nrows(r), ncols(c), rowPtr(CheckedRows(r, c) + 1, 0)
+  {
+  }
+  // построение по списку (i, j, value); повторяющиеся позиции суммируются
+  TSparseMatrix(size_t r, size_t c, const vector<TTriplet<T>>& t) : nrows(r), ncols(c)
+  {
+    rowPtr.assign(CheckedRows(r, c) + 1, 0);
+    for (const TTriplet<T>& e : t)
+    {
+      if (e.row >= r || e.col >= c)
+        throw out_of_range("Matrix index is out of range");
+      rowPtr[e.row + 1]++;
+    }
+    for (size_t i = 0; i < r; i++)
+      rowPtr[i + 1] += rowPtr[i];
+
+    // раскладка по строкам (сортировка подсчетом)
+    vector<size_t> pos(rowPtr.begin(), rowPtr.end() - 1);
+    vector<size_t> order(t.size());
+    for (size_t k = 0; k < t.size(); k++)
+      order[pos[t[k].row]++] = k;
+
+    colIdx.reserve(t.size());
+    values.reserve(t.size());
+    size_t start = 0;
+    for (size_t i = 0; i < r; i++)
+    {
+      auto first = order.begin() + rowPtr[i], last = order.begin() + rowPtr[i + 1];
+      stable_sort(first, last, [&t](size_t a, size_t b) { return t[a].col < t[b].col; });
+      for (auto it = first; it != last; ++it)
+      {
+        const TTriplet<T>& e = t[*it];
+        if (colIdx.size() > start && colIdx.back() == e.col)
+          values.back() += e.val;
+        else
+        {
+          colIdx.push_back(e.col);
+          values.push_back(e.val);
+        }
+      }
+      rowPtr[i] = start;
+      start = colIdx.size();
+    }
+    rowPtr[r] = start;
+  }
+  // из плотной матрицы: сохраняются только ненулевые элементы
+  explicit TSparseMatrix(const TDynamicMatrix<T>& m) : nrows(m.rows()), ncols(m.cols()), rowPtr(m.rows() + 1, 0)
+  {
+    for (size_t i = 0; i < nrows; i++)
+    {
+      const T* row = m[i];
+      for (size_t j = 0; j < ncols; j++)
+        if (!(row[j] == T()))
+        {
+          colIdx.push_back(j);
+          values.push_back(row[j]);
+        }
+      rowPtr[i + 1] = colIdx.size();
+    }
+  }
+
+  size_t rows() const noexcept { return nrows; }
+  size_t cols() const noexcept { return ncols; }
+  // число хранимых элементов
+  size_t nnz() const noexcept { return values.size(); }
+
+  // доступ к элементу с контролем; отсутствующие элементы равны T()
+  T at(size_t i, size_t j) const
+  {
+    if (i >= nrows || j >= ncols)
+      throw out_of_range("Matrix index is out of range");
+    auto first = colIdx.begin() + rowPtr[i], last = colIdx.begin() + rowPtr[i + 1];
+    auto it = lower_bound(first, last, j);
+    if (it == last || *it != j)
+      return T();
+    return values[it - colIdx.begin()];
+  }
+
+  TDynamicMatrix<T> dense() const
+  {
+    TDynamicMatrix<T> res(nrows, ncols);
+    for (size_t i = 0; i < nrows; i++)
+      for (size_t k = rowPtr[i]; k < rowPtr[i + 1]; k++)
+        res[i][colIdx[k]] = values[k];
+    return res;
+  }
+
+  // сравнение (по хранимой структуре)
+  bool operator==(const TSparseMatrix& m) const noexcept
+  {
+    return nrows == m.nrows && ncols == m.ncols && rowPtr == m.rowPtr &&
+      colIdx == m.colIdx && values == m.values;
+  }
+  bool operator!=(const TSparseMatrix& m) const noexcept
+  {
+    return !(*this == m);
+  }
+
+  // матрично-скалярные операции
+  TSparseMatrix operator*(const T& val) const
+  {
+    TSparseMatrix res(*this);
+    for (T& x : res.values)
+      x *= val;
+    return res;
+  }
+
+  // матрично-векторные операции (SpMV): O(nnz)
+  TDynamicVector<T> operator*(TVectorView<const T> v) const
+  {
+    if (ncols != v.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    TDynamicVector<T> res(nrows, NO_INIT);
+    const size_t* ci = colIdx.data();
+    const T* val = values.data();
+    for (size_t i = 0; i < nrows; i++)
+    {
+      T sum = T();
+      for (size_t k = rowPtr[i]; k < rowPtr[i + 1]; k++)
+        sum += val[k] * v[ci[k]];
+      res[i] = sum;
+    }
+    return res;
+  }
+
+  // вывод: по строке "i j value" на каждый хранимый элемент
+  friend ostream& operator<<(ostream& ostr, const TSparseMatrix& m)
+  {
+    for (size_t i = 0; i < m.nrows; i++)
+      for (size_t k = m.rowPtr[i]; k < m.rowPtr[i + 1]; k++)
+        ostr << i << ' ' << m.colIdx[k] << ' ' << m.values[k] << endl;
+    return ostr;
+  }
+};
+
+#endif
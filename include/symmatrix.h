@@ -0,0 +1,186 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TSymmetricMatrix_H__
+#define __TSymmetricMatrix_H__
+
+#include "tmatrix.h"
+
+// Симметричная матрица -
+// хранит только верхний треугольник (a[i][j], j >= i) упакованным по строкам,
+// как TUpperTriangularMatrix; a[j][i] == a[i][j] восстанавливается при доступе
+template<typename T, typename Alloc = TAlignedAllocator<T>>
+class TSymmetricMatrix : private TDynamicVector<T, Alloc, 0>
+{
+  using TDynamicVector<T, Alloc, 0>::pMem;
+
+  size_t dim;
+
+  static size_t CheckedSize(size_t s)
+  {
+    if (s == 0)
+      throw out_of_range("Matrix size should be greater than zero");
+    if (s > MAX_MATRIX_SIZE)
+      throw out_of_range("Matrix size should not exceed MAX_MATRIX_SIZE");
+    return s * (s + 1) / 2;
+  }
+
+  // смещение начала строки i в упакованном буфере
+  size_t RowOffset(size_t i) const noexcept { return i * dim - i * (i - 1) / 2; }
+
+  TSymmetricMatrix(TDynamicVector<T, Alloc, 0>&& v, size_t s) : TDynamicVector<T, Alloc, 0>(std::move(v)), dim(s) {}
+public:
+  TSymmetricMatrix(size_t s = 1) : TDynamicVector<T, Alloc, 0>(CheckedSize(s)), dim(s)
+  {
+  }
+
+  size_t size() const noexcept { return dim; }
+
+  // индексация: m[i][j] допустима только при j >= i, без контроля
+  T* operator[](size_t ind)
+  {
+    return pMem + RowOffset(ind) - ind;
+  }
+  const T* operator[](size_t ind) const
+  {
+    return pMem + RowOffset(ind) - ind;
+  }
+  // индексация с контролем; at(i, j) и at(j, i) - один и тот же элемент
+  T& at(size_t i, size_t j)
+  {
+    if (i >= dim || j >= dim)
+      throw out_of_range("Matrix index is out of range");
+    return i <= j ? (*this)[i][j] : (*this)[j][i];
+  }
+  const T& at(size_t i, size_t j) const
+  {
+    if (i >= dim || j >= dim)
+      throw out_of_range("Matrix index is out of range");
+    return i <= j ? (*this)[i][j] : (*this)[j][i];
+  }
+
+  TDynamicMatrix<T> dense() const
+  {
+    TDynamicMatrix<T> res(dim, dim, NO_INIT);
+    for (size_t i = 0; i < dim; i++)
+      for (size_t j = i; j < dim; j++)
+        res[i][j] = res[j][i] = (*this)[i][j];
+    return res;
+  }
+
+  // сравнение
+  bool operator==(const TSymmetricMatrix& m) const noexcept
+  {
+    return dim == m.dim && TDynamicVector<T, Alloc, 0>::operator==(m);
+  }
+  bool operator!=(const TSymmetricMatrix& m) const noexcept
+  {
+    return !(*this == m);
+  }
+
+  // матрично-скалярные операции
+  TSymmetricMatrix operator*(const T& val) const
+  {
+    return TSymmetricMatrix(TDynamicVector<T, Alloc, 0>::operator*(val), dim);
+  }
+
+  // матрично-векторные операции: каждый хранимый a[i][j] читается один раз
+  // и дает вклад в y[i] и (вне диагонали) в y[j]
+  TDynamicVector<T> operator*(TVectorView<const T> v) const
+  {
+    if (dim != v.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    TDynamicVector<T> res(dim);
+    const T* row = pMem;
+    for (size_t i = 0; i < dim; i++)
+    {
+      const T xi = v[i];
+      T sum = row[0] * xi;
+      for (size_t j = i + 1; j < dim; j++)
+      {
+        const T a = row[j - i];
+        sum += a * v[j];
+        res[j] += a * xi;
+      }
+      res[i] += sum;
+      row += dim - i;
+    }
+    return res;
+  }
+
+  // матрично-матричные операции
+  TSymmetricMatrix operator+(const TSymmetricMatrix& m) const
+  {
+    if (dim != m.dim)
+      throw length_error("Matrices should have equal sizes");
+    return TSymmetricMatrix(TDynamicVector<T, Alloc, 0>::operator+(m), dim);
+  }
+  TSymmetricMatrix operator-(const TSymmetricMatrix& m) const
+  {
+    if (dim != m.dim)
+      throw length_error("Matrices should have equal sizes");
+    return TSymmetricMatrix(TDynamicVector<T, Alloc, 0>::operator-(m), dim);
+  }
+
+  // симметричное обновление ранга k: C += alpha * A * A^T, A - матрица n x k.
+  // Вычисляется только хранимый треугольник, каждый элемент C
+  // читается и записывается один раз
+  TSymmetricMatrix& rank_update(TMatrixView<const T> a, const T& alpha = T(1))
+  {
+    if (a.rows() != dim)
+      throw length_error("Matrix sizes should be compatible");
+    T* row = pMem;
+    for (size_t i = 0; i < dim; i++)
+    {
+      const T* ai = a[i];
+      for (size_t j = i; j < dim; j++)
+      {
+        const T* aj = a[j];
+        T sum = T();
+        for (size_t p = 0; p < a.cols(); p++)
+          sum += ai[p] * aj[p];
+        row[j - i] += alpha * sum;
+      }
+      row += dim - i;
+    }
+    return *this;
+  }
+  // симметричное обновление ранга 1: C += alpha * x * x^T
+  TSymmetricMatrix& rank_update(TVectorView<const T> x, const T& alpha = T(1))
+  {
+    if (x.size() != dim)
+      throw length_error("Matrix and vector sizes should be compatible");
+    T* row = pMem;
+    for (size_t i = 0; i < dim; i++)
+    {
+      const T axi = alpha * x[i];
+      for (size_t j = i; j < dim; j++)
+        row[j - i] += axi * x[j];
+      row += dim - i;
+    }
+    return *this;
+  }
+
+  // ввод/вывод: вводится верхний треугольник, выводится полная матрица
+  friend istream& operator>>(istream& istr, TSymmetricMatrix& v)
+  {
+    for (size_t i = 0; i < v.size() * (v.size() + 1) / 2; i++)
+      istr >> v.pMem[i]; // требуется оператор>> для типа T
+    return istr;
+  }
+  friend ostream& operator<<(ostream& ostr, const TSymmetricMatrix& v)
+  {
+    for (size_t i = 0; i < v.dim; i++)
+    {
+      for (size_t j = 0; j < v.dim; j++)
+        ostr << v.at(i, j) << ' '; // требуется оператор<< для типа T
+      ostr << endl;
+    }
+    return ostr;
+  }
+};
+
+#endif
@@ -0,0 +1,193 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TAllocator_H__
+#define __TAllocator_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Выравнивание буферов по умолчанию - строка кэша (и регистр AVX-512)
+const size_t DEFAULT_ALIGNMENT = 64;
+
+// Аллокатор с выравниванием -
+// выделяет память, выровненную по границе Align байт (но не меньше alignof(T)).
+// Удовлетворяет требованиям Allocator, поэтому вместо него в TDynamicVector
+// можно подставить любой другой аллокатор (пул, huge pages и т.п.)
+template<typename T, size_t Align = DEFAULT_ALIGNMENT>
+class TAlignedAllocator
+{
+  static_assert((Align & (Align - 1)) == 0, "Alignment should be a power of two");
+public:
+  using value_type = T;
+  static const size_t alignment = Align < alignof(T) ? alignof(T) : Align;
+
+  template<typename U>
+  struct rebind { using other = TAlignedAllocator<U, Align>; };
+
+  TAlignedAllocator() noexcept {}
+  template<typename U>
+  TAlignedAllocator(const TAlignedAllocator<U, Align>&) noexcept {}
+
+  T* allocate(size_t n)
+  {
+    if (n > size_t(-1) / sizeof(T))
+      throw std::bad_array_new_length();
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+  }
+  void deallocate(T* p, size_t) noexcept
+  {
+    ::operator delete(p, std::align_val_t(alignment));
+  }
+
+  template<typename U>
+  bool operator==(const TAlignedAllocator<U, Align>&) const noexcept { return true; }
+  template<typename U>
+  bool operator!=(const TAlignedAllocator<U, Align>&) const noexcept { return false; }
+};
+
+// Размер большой страницы (x86-64, AArch64 с гранулой 4 КБ)
+const size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+// Аллокатор на больших страницах -
+// буферы от Threshold байт выделяются отдельным отображением, выровненным
+// на HUGE_PAGE_SIZE: сначала из пула HugeTLB (MAP_HUGETLB), при его
+// отсутствии - обычными страницами с madvise(MADV_HUGEPAGE), чтобы ядро
+// собрало их в прозрачные большие страницы (THP). Меньшие буферы и другие
+// платформы - как TAlignedAllocator. Фактический результат - page_backing()
+template<typename T, size_t Threshold = HUGE_PAGE_SIZE>
+class THugePageAllocator
+{
+  static bool IsLarge(size_t n) noexcept { return n * sizeof(T) >= Threshold; }
+  static size_t MappedBytes(size_t n) noexcept
+  {
+    return (n * sizeof(T) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+public:
+  using value_type = T;
+  static const size_t alignment = DEFAULT_ALIGNMENT < alignof(T) ? alignof(T) : DEFAULT_ALIGNMENT;
+
+  template<typename U>
+  struct rebind { using other = THugePageAllocator<U, Threshold>; };
+
+  THugePageAllocator() noexcept {}
+  template<typename U>
+  THugePageAllocator(const THugePageAllocator<U, Threshold>&) noexcept {}
+
+  T* allocate(size_t n)
+  {
+    if (n > (size_t(-1) - HUGE_PAGE_SIZE) / sizeof(T))
+      throw std::bad_array_new_length();
+#ifdef __linux__
+    if (IsLarge(n))
+    {
+      const size_t len = MappedBytes(n);
+      int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_2MB
+      flags |= MAP_HUGE_2MB;
+#endif
+      void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+      if (p != MAP_FAILED)
+        return static_cast<T*>(p);
+
+      // пул HugeTLB пуст: запас в одну страницу для выравнивания, лишнее снимается
+      char* q = static_cast<char*>(mmap(nullptr, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+      if (q == MAP_FAILED)
+        throw std::bad_alloc();
+      char* a = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(q) + HUGE_PAGE_SIZE - 1) & ~uintptr_t(HUGE_PAGE_SIZE - 1));
+      if (a != q)
+        munmap(q, size_t(a - q));
+      if (a + len != q + len + HUGE_PAGE_SIZE)
+        munmap(a + len, size_t(q + HUGE_PAGE_SIZE - a));
+      madvise(a, len, MADV_HUGEPAGE); // без THP остаются обычные страницы
+      return reinterpret_cast<T*>(a);
+    }
+#endif
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+  }
+  void deallocate(T* p, size_t n) noexcept
+  {
+#ifdef __linux__
+    if (IsLarge(n))
+    {
+      munmap(p, MappedBytes(n));
+      return;
+    }
+#endif
+    ::operator delete(p, std::align_val_t(alignment));
+  }
+
+  template<typename U>
+  bool operator==(const THugePageAllocator<U, Threshold>&) const noexcept { return true; }
+  template<typename U>
+  bool operator!=(const THugePageAllocator<U, Threshold>&) const noexcept { return false; }
+};
+
+// Вид страниц, на которых фактически размещен адрес p
+enum TPageBacking { PAGES_DEFAULT, PAGES_TRANSPARENT_HUGE, PAGES_HUGETLB };
+
+// Определяется по /proc/self/smaps: KernelPageSize отображения и объем
+// AnonHugePages (THP появляются лишь после первого обращения к памяти).
+// На других платформах - PAGES_DEFAULT
+inline TPageBacking page_backing(const void* p)
+{
+  TPageBacking res = PAGES_DEFAULT;
+#ifdef __linux__
+  FILE* f = fopen("/proc/self/smaps", "r");
+  if (f == nullptr)
+    return res;
+  const unsigned long addr = static_cast<unsigned long>(reinterpret_cast<uintptr_t>(p));
+  unsigned long lo, hi, kb;
+  bool inside = false;
+  char line[1024];
+  while (fgets(line, sizeof(line), f) != nullptr)
+  {
+    if (sscanf(line, "%lx-%lx ", &lo, &hi) == 2)
+    {
+      if (inside)
+        break;
+      inside = addr >= lo && addr < hi;
+    }
+    else if (inside && sscanf(line, "KernelPageSize: %lu kB", &kb) == 1 && kb >= HUGE_PAGE_SIZE / 1024)
+      res = PAGES_HUGETLB;
+    else if (inside && res == PAGES_DEFAULT && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1 && kb > 0)
+      res = PAGES_TRANSPARENT_HUGE;
+  }
+  fclose(f);
+#else
+  (void)p;
+#endif
+  return res;
+}
+
+// Удалитель чужого буфера, переданного во владение вектору:
+// хранит произвольный функтор D, вызываемый как d(p)
+template<typename T>
+class TBufferDeleter
+{
+public:
+  virtual ~TBufferDeleter() {}
+  virtual void operator()(T* p) noexcept = 0;
+};
+
+template<typename T, typename D>
+class TBufferDeleterImpl : public TBufferDeleter<T>
+{
+  D d;
+public:
+  TBufferDeleterImpl(D deleter) : d(std::move(deleter)) {}
+  void operator()(T* p) noexcept override { d(p); }
+};
+
+#endif
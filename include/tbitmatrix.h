@@ -0,0 +1,268 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TBitMatrix_H__
+#define __TBitMatrix_H__
+
+// Подключается в конце tmatrix.h: специализация должна быть видна
+// везде, где используется TDynamicMatrix<bool>
+
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// число единичных битов и номер младшего единичного бита (w != 0)
+inline size_t BitCount(uint64_t w) noexcept
+{
+#ifdef _MSC_VER
+  return size_t(__popcnt64(w));
+#else
+  return size_t(__builtin_popcountll(w));
+#endif
+}
+inline size_t LowBit(uint64_t w) noexcept
+{
+#ifdef _MSC_VER
+  unsigned long ind;
+  _BitScanForward64(&ind, w);
+  return ind;
+#else
+  return size_t(__builtin_ctzll(w));
+#endif
+}
+
+// Булева матрица -
+// специализация TDynamicMatrix<bool>: по 64 элемента в машинном слове.
+// Строка i занимает words() слов подряд, элемент (i, j) - бит j % 64
+// слова j / 64 строки. Неиспользуемые биты последнего слова строки
+// всегда нулевые, поэтому операции идут по словам целиком.
+// Сумма - поэлементное ИЛИ, произведение - ИЛИ от И
+template<typename Alloc>
+class TDynamicMatrix<bool, Alloc, TRowMajor>
+  : private TDynamicVector<uint64_t, typename allocator_traits<Alloc>::template rebind_alloc<uint64_t>, 0>
+{
+  using TWords = TDynamicVector<uint64_t, typename allocator_traits<Alloc>::template rebind_alloc<uint64_t>, 0>;
+  using TWords::pMem;
+
+  size_t nrows, ncols, nwords;
+
+  static size_t CheckedSize(size_t r, size_t c)
+  {
+    if (r == 0 || c == 0)
+      throw out_of_range("Matrix size should be greater than zero");
+    if (c > MAX_MATRIX_ELEMENTS / r)
+      throw out_of_range("Matrix size should not exceed MAX_MATRIX_ELEMENTS");
+    return r * ((c + 63) / 64);
+  }
+public:
+  // ссылка на элемент - бит слова
+  class reference
+  {
+    uint64_t* w;
+    uint64_t mask;
+  public:
+    reference(uint64_t* word, size_t bit) noexcept : w(word), mask(uint64_t(1) << bit) {}
+    operator bool() const noexcept { return (*w & mask) != 0; }
+    reference& operator=(bool val) noexcept
+    {
+      *w = val ? *w | mask : *w & ~mask;
+      return *this;
+    }
+    reference& operator=(const reference& r) noexcept { return *this = bool(r); }
+  };
+  // строка для записи m[i][j] = ... и чтения m[i][j]
+  class row_reference
+  {
+    uint64_t* w;
+  public:
+    row_reference(uint64_t* words) noexcept : w(words) {}
+    reference operator[](size_t j) const noexcept { return reference(w + j / 64, j % 64); }
+  };
+  class const_row_reference
+  {
+    const uint64_t* w;
+  public:
+    const_row_reference(const uint64_t* words) noexcept : w(words) {}
+    bool operator[](size_t j) const noexcept { return (w[j / 64] >> (j % 64)) & 1; }
+  };
+
+  TDynamicMatrix(size_t s = 1) : TDynamicMatrix(s, s)
+  {
+  }
+  TDynamicMatrix(size_t r, size_t c) : TWords(CheckedSize(r, c)), nrows(r), ncols(c), nwords((c + 63) / 64)
+  {
+  }
+  TDynamicMatrix(const TDynamicMatrix& m) = default;
+  // перемещенная матрица пуста: 0 x 0
+  TDynamicMatrix(TDynamicMatrix&& m) noexcept
+    : TWords(std::move(m)), nrows(m.nrows), ncols(m.ncols), nwords(m.nwords)
+  {
+    m.nrows = m.ncols = m.nwords = 0;
+  }
+  TDynamicMatrix& operator=(const TDynamicMatrix& m) = default;
+  TDynamicMatrix& operator=(TDynamicMatrix&& m) noexcept
+  {
+    if (this == &m)
+      return *this;
+    TWords::operator=(std::move(m));
+    nrows = m.nrows;
+    ncols = m.ncols;
+    nwords = m.nwords;
+    m.nrows = m.ncols = m.nwords = 0;
+    return *this;
+  }
+
+  size_t size() const noexcept { return nrows; }
+  size_t rows() const noexcept { return nrows; }
+  size_t cols() const noexcept { return ncols; }
+  // число слов в строке и сами слова
+  size_t words() const noexcept { return nwords; }
+  uint64_t* data() noexcept { return pMem; }
+  const uint64_t* data() const noexcept { return pMem; }
+
+  // индексация: m[i][j] без контроля
+  row_reference operator[](size_t ind) { return row_reference(pMem + ind * nwords); }
+  const_row_reference operator[](size_t ind) const { return const_row_reference(pMem + ind * nwords); }
+  // индексация с контролем
+  reference at(size_t i, size_t j)
+  {
+    if (i >= nrows || j >= ncols)
+      throw out_of_range("Matrix index is out of range");
+    return (*this)[i][j];
+  }
+  bool at(size_t i, size_t j) const
+  {
+    if (i >= nrows || j >= ncols)
+      throw out_of_range("Matrix index is out of range");
+    return (*this)[i][j];
+  }
+
+  // число единичных элементов
+  size_t count() const noexcept
+  {
+    size_t res = 0;
+    for (size_t k = 0; k < nrows * nwords; k++)
+      res += BitCount(pMem[k]);
+    return res;
+  }
+
+  // сравнение
+  bool operator==(const TDynamicMatrix& m) const noexcept
+  {
+    return nrows == m.nrows && ncols == m.ncols && TWords::operator==(m);
+  }
+  bool operator!=(const TDynamicMatrix& m) const noexcept
+  {
+    return !(*this == m);
+  }
+
+  // матрично-векторные операции: y[i] = ИЛИ_j (a[i][j] И v[j]),
+  // вектор упаковывается в слова, строка проверяется по словам
+  TDynamicVector<bool> operator*(const TDynamicVector<bool>& v) const
+  {
+    if (ncols != v.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    TWords packed(nwords);
+    for (size_t j = 0; j < ncols; j++)
+      if (v[j])
+        packed[j / 64] |= uint64_t(1) << (j % 64);
+    TDynamicVector<bool> res(nrows, NO_INIT);
+    for (size_t i = 0; i < nrows; i++)
+    {
+      const uint64_t* row = pMem + i * nwords;
+      uint64_t acc = 0;
+      for (size_t k = 0; k < nwords; k++)
+        acc |= row[k] & packed[k];
+      res[i] = acc != 0;
+    }
+    return res;
+  }
+
+  // матрично-матричные операции
+  TDynamicMatrix operator+(const TDynamicMatrix& m) const
+  {
+    if (nrows != m.nrows || ncols != m.ncols)
+      throw length_error("Matrices should have equal sizes");
+    TDynamicMatrix res(nrows, ncols);
+    for (size_t k = 0; k < nrows * nwords; k++)
+      res.pMem[k] = pMem[k] | m.pMem[k];
+    return res;
+  }
+  // c[i] = ИЛИ строк m[k] по всем единичным a[i][k]: внутренний цикл -
+  // ИЛИ строк по словам (векторизуется компилятором)
+  TDynamicMatrix operator*(const TDynamicMatrix& m) const
+  {
+    if (ncols != m.nrows)
+      throw length_error("Matrix sizes should be compatible");
+    TDynamicMatrix res(nrows, m.ncols);
+    for (size_t i = 0; i < nrows; i++)
+    {
+      uint64_t* rrow = res.pMem + i * res.nwords;
+      const uint64_t* row = pMem + i * nwords;
+      for (size_t kw = 0; kw < nwords; kw++)
+        for (uint64_t w = row[kw]; w != 0; w &= w - 1)
+        {
+          const uint64_t* mrow = m.pMem + (kw * 64 + LowBit(w)) * m.nwords;
+          for (size_t j = 0; j < m.nwords; j++)
+            rrow[j] |= mrow[j];
+        }
+    }
+    return res;
+  }
+
+  // транспонирование блоками 64 x 64 бит: блок из 64 слов
+  // транспонируется за 6 проходов обменов половин
+  TDynamicMatrix transpose() const
+  {
+    TDynamicMatrix res(ncols, nrows);
+    uint64_t blk[64];
+    for (size_t bi = 0; bi < ncols; bi += 64)
+      for (size_t bj = 0; bj < nrows; bj += 64)
+      {
+        // blk[k] - слово bi / 64 строки bj + k
+        for (size_t k = 0; k < 64; k++)
+          blk[k] = bj + k < nrows ? pMem[(bj + k) * nwords + bi / 64] : 0;
+        uint64_t mask = 0x00000000FFFFFFFFull;
+        for (size_t s = 32; s != 0; s >>= 1, mask ^= mask << s)
+          for (size_t k = 0; k < 64; k = ((k | s) + 1) & ~s)
+          {
+            const uint64_t t = ((blk[k] >> s) ^ blk[k | s]) & mask;
+            blk[k] ^= t << s;
+            blk[k | s] ^= t;
+          }
+        // теперь blk[k] - слово bj / 64 строки bi + k результата
+        for (size_t k = 0; k < 64 && bi + k < ncols; k++)
+          res.pMem[(bi + k) * res.nwords + bj / 64] = blk[k];
+      }
+    return res;
+  }
+
+  // ввод/вывод: элементы - 0 или 1
+  friend istream& operator>>(istream& istr, TDynamicMatrix& v)
+  {
+    for (size_t i = 0; i < v.nrows; i++)
+      for (size_t j = 0; j < v.ncols; j++)
+      {
+        bool val;
+        istr >> val;
+        v[i][j] = val;
+      }
+    return istr;
+  }
+  friend ostream& operator<<(ostream& ostr, const TDynamicMatrix& v)
+  {
+    for (size_t i = 0; i < v.nrows; i++)
+    {
+      for (size_t j = 0; j < v.ncols; j++)
+        ostr << v[i][j] << ' ';
+      ostr << endl;
+    }
+    return ostr;
+  }
+};
+
+#endif
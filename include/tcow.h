@@ -0,0 +1,148 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TCopyOnWrite_H__
+#define __TCopyOnWrite_H__
+
+#include <atomic>
+#include "tmatrix.h"
+
+// Хранилище с копированием при записи -
+// копии разделяют один объект S (вектор или матрицу) с атомарным счетчиком
+// ссылок, поэтому копирование стоит O(1). Объект дублируется при первом
+// изменяющем доступе (неконстантные operator[], at, mutate) к разделяемой
+// копии. Чтение - через константные operator[], at, operator*, operator->.
+// Указатели и ссылки, полученные для записи, действительны до следующего
+// копирования этого объекта. Перемещенный объект можно только
+// присвоить или разрушить
+template<typename S>
+class TCopyOnWrite
+{
+  struct TBlock
+  {
+    atomic<size_t> refs;
+    S value;
+  };
+  TBlock* p;
+
+  void Release() noexcept
+  {
+    if (p != nullptr && p->refs.fetch_sub(1, memory_order_acq_rel) == 1)
+      delete p;
+    p = nullptr;
+  }
+public:
+  TCopyOnWrite(S value = S()) : p(new TBlock{ { 1 }, std::move(value) })
+  {
+  }
+  TCopyOnWrite(const TCopyOnWrite& v) noexcept : p(v.p)
+  {
+    p->refs.fetch_add(1, memory_order_relaxed);
+  }
+  TCopyOnWrite(TCopyOnWrite&& v) noexcept : p(v.p)
+  {
+    v.p = nullptr;
+  }
+  ~TCopyOnWrite()
+  {
+    Release();
+  }
+  TCopyOnWrite& operator=(const TCopyOnWrite& v) noexcept
+  {
+    if (p != v.p)
+    {
+      v.p->refs.fetch_add(1, memory_order_relaxed);
+      Release();
+      p = v.p;
+    }
+    return *this;
+  }
+  TCopyOnWrite& operator=(TCopyOnWrite&& v) noexcept
+  {
+    swap(p, v.p);
+    return *this;
+  }
+
+  // число копий, разделяющих объект
+  size_t use_count() const noexcept { return p->refs.load(memory_order_acquire); }
+
+  // доступ на чтение без копирования
+  const S& get() const noexcept { return p->value; }
+  const S& operator*() const noexcept { return p->value; }
+  const S* operator->() const noexcept { return &p->value; }
+  // доступ на запись: разделяемый объект сначала дублируется
+  S& mutate()
+  {
+    if (p->refs.load(memory_order_acquire) != 1)
+    {
+      TBlock* q = new TBlock{ { 1 }, p->value };
+      Release();
+      p = q;
+    }
+    return p->value;
+  }
+
+  size_t size() const noexcept { return p->value.size(); }
+
+  // индексация
+  decltype(auto) operator[](size_t ind) const { return get()[ind]; }
+  decltype(auto) operator[](size_t ind) { return mutate()[ind]; }
+  // индексация с контролем: at(i) для вектора, at(i, j) для матрицы
+  template<typename... I>
+  decltype(auto) at(I... ind) const { return get().at(ind...); }
+  template<typename... I>
+  decltype(auto) at(I... ind) { return mutate().at(ind...); }
+
+  // сравнение; разделяющие объект копии равны без сравнения элементов
+  bool operator==(const TCopyOnWrite& v) const noexcept
+  {
+    return p == v.p || get() == v.get();
+  }
+  bool operator!=(const TCopyOnWrite& v) const noexcept
+  {
+    return !(*this == v);
+  }
+
+  // операции выполняет хранимый объект, результат - новый объект
+  // (выражения вычисляются сразу: они ссылались бы на разделяемый объект)
+  template<typename U>
+  auto operator+(const U& v) const { return Evaluate(get() + Unwrap(v)); }
+  template<typename U>
+  auto operator-(const U& v) const { return Evaluate(get() - Unwrap(v)); }
+  template<typename U>
+  auto operator*(const U& v) const { return Evaluate(get() * Unwrap(v)); }
+
+  // ввод/вывод
+  friend istream& operator>>(istream& istr, TCopyOnWrite& v)
+  {
+    return istr >> v.mutate();
+  }
+  friend ostream& operator<<(ostream& ostr, const TCopyOnWrite& v)
+  {
+    return ostr << v.get();
+  }
+private:
+  template<typename U>
+  static const U& Unwrap(const U& v) noexcept { return v; }
+  template<typename U>
+  static const U& Unwrap(const TCopyOnWrite<U>& v) noexcept { return v.get(); }
+  template<typename R>
+  static auto Evaluate(R r)
+  {
+    if constexpr (TIsExpr<R>::value)
+      return S(r);
+    else
+      return r;
+  }
+};
+
+template<typename T, typename Alloc = TAlignedAllocator<T>>
+using TCowVector = TCopyOnWrite<TDynamicVector<T, Alloc>>;
+
+template<typename T, typename Alloc = TAlignedAllocator<T>>
+using TCowMatrix = TCopyOnWrite<TDynamicMatrix<T, Alloc>>;
+
+#endif
@@ -0,0 +1,419 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TExpr_H__
+#define __TExpr_H__
+
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "tsimd.h"
+
+// Шаблоны выражений.
+// Поэлементные операции над векторами и матрицами (+, - и умножение на
+// скаляр) не вычисляют результат, а возвращают легкий объект-выражение -
+// дерево узлов, ссылающихся на буферы операндов. Выражение вычисляется
+// за один векторизованный проход без промежуточных буферов, когда из него
+// создается или ему присваивается вектор (матрица):
+//   c = a + b * 2 - d; // один проход, ни одного временного вектора
+// Сумма с произведением (a + b * 2) вычисляется одной командой fma
+// Выражение не владеет операндами: его нельзя хранить дольше них
+// (auto e = a + b; - ссылка на a и b)
+// Произведения с выражением (скалярное, матрично-векторное и матричное)
+// вычисляют его во временный буфер; m[i][j] вычисляет один элемент
+
+struct TRowMajor;
+
+// Узлы: value_type, элемент operator[](i), регистр Load<V>(i, r) и признак
+// usesMul - для вычисления нужно векторное умножение.
+// Функции над регистрами V собираются под набор V::isa (MP2_KERNEL)
+template<typename T>
+struct TExprLeaf
+{
+  using value_type = T;
+  static constexpr bool usesMul = false;
+  const T* p;
+
+  explicit TExprLeaf(const T* data) noexcept : p(data) {}
+  T operator[](size_t i) const { return p[i]; }
+  template<typename V>
+  MP2_KERNEL(V) void Load(size_t i, typename V::reg& r) const { r = V::load(p + i); }
+};
+
+template<typename T>
+struct TExprScalar
+{
+  using value_type = T;
+  static constexpr bool usesMul = false;
+  T s;
+
+  explicit TExprScalar(const T& val) : s(val) {}
+  T operator[](size_t) const { return s; }
+  template<typename V>
+  MP2_KERNEL(V) void Load(size_t, typename V::reg& r) const { r = V::set1(s); }
+};
+
+struct TExprAdd
+{
+  static constexpr bool usesMul = false;
+  template<typename T>
+  static T Apply(const T& a, const T& b) { return a + b; }
+  template<typename V>
+  MP2_KERNEL(V) static void Apply(typename V::reg& a, const typename V::reg& b) { a = V::add(a, b); }
+};
+struct TExprSub
+{
+  static constexpr bool usesMul = false;
+  template<typename T>
+  static T Apply(const T& a, const T& b) { return a - b; }
+  template<typename V>
+  MP2_KERNEL(V) static void Apply(typename V::reg& a, const typename V::reg& b) { a = V::sub(a, b); }
+};
+struct TExprMul
+{
+  static constexpr bool usesMul = true;
+  template<typename T>
+  static T Apply(const T& a, const T& b) { return a * b; }
+  template<typename V>
+  MP2_KERNEL(V) static void Apply(typename V::reg& a, const typename V::reg& b) { a = V::mul(a, b); }
+};
+
+template<typename Op, typename L, typename R>
+struct TExprBinary;
+
+// узел - произведение (слагаемое, которое можно слить со сложением в fma)
+template<typename N>
+struct TIsExprMul : std::false_type {};
+template<typename L, typename R>
+struct TIsExprMul<TExprBinary<TExprMul, L, R>> : std::true_type {};
+
+template<typename Op, typename L, typename R>
+struct TExprBinary
+{
+  using value_type = typename L::value_type;
+  static constexpr bool usesMul = Op::usesMul || L::usesMul || R::usesMul;
+  L l;
+  R r;
+
+  TExprBinary(const L& left, const R& right) : l(left), r(right) {}
+  value_type operator[](size_t i) const { return Op::Apply(l[i], r[i]); }
+  template<typename V>
+  MP2_KERNEL(V) void Load(size_t i, typename V::reg& res) const
+  {
+    // a + b * c и a * b + c - одна команда fma
+    typename V::reg x, y;
+    if constexpr (std::is_same<Op, TExprAdd>::value && TIsExprMul<R>::value)
+    {
+      l.template Load<V>(i, res);
+      r.l.template Load<V>(i, x);
+      r.r.template Load<V>(i, y);
+      res = V::fma(x, y, res);
+    }
+    else if constexpr (std::is_same<Op, TExprAdd>::value && TIsExprMul<L>::value)
+    {
+      l.l.template Load<V>(i, x);
+      l.r.template Load<V>(i, y);
+      r.template Load<V>(i, res);
+      res = V::fma(x, y, res);
+    }
+    else
+    {
+      l.template Load<V>(i, res);
+      r.template Load<V>(i, x);
+      Op::template Apply<V>(res, x);
+    }
+  }
+};
+
+// res[0..n) = e[0..n) над регистрами V; хвост - поэлементно
+template<typename V, typename T, typename E>
+MP2_KERNEL(V) void ExprKernel(const E& e, T* res, size_t n)
+{
+  size_t i = 0;
+  if constexpr (!E::usesMul || V::hasMul)
+    for (; i + V::width <= n; i += V::width)
+    {
+      typename V::reg r;
+      e.template Load<V>(i, r);
+      V::store(res + i, r);
+    }
+  for (; i < n; i++)
+    res[i] = e[i];
+}
+
+#ifdef MP2_SIMD_X86
+// входы уровней: все дерево выражения встраивается в один цикл
+template<typename T, typename E>
+struct TExprEntry
+{
+  MP2_SIMD_ENTRY("sse2") static void Sse2(const E& e, T* res, size_t n) { ExprKernel<TSse2<T>>(e, res, n); }
+  MP2_SIMD_ENTRY("avx2,fma") static void Avx2(const E& e, T* res, size_t n) { ExprKernel<TAvx2<T>>(e, res, n); }
+  MP2_SIMD_ENTRY("avx512f,avx512dq") static void Avx512(const E& e, T* res, size_t n) { ExprKernel<TAvx512<T>>(e, res, n); }
+};
+#endif
+
+// вычисление выражения; уровни без нужного выражению умножения пропускаются.
+// res может совпадать с буфером операнда: элемент i читается до записи
+template<typename T, typename E>
+void EvalExpr(const E& e, T* res, size_t n)
+{
+#ifdef MP2_SIMD_X86
+  if constexpr (TIsSimdType<T>::value)
+  {
+    const TSimdLevel level = simd_level();
+    if (level >= SIMD_AVX512 && (!E::usesMul || TAvx512<T>::hasMul))
+      return TExprEntry<T, E>::Avx512(e, res, n);
+    if (level >= SIMD_AVX2 && (!E::usesMul || TAvx2<T>::hasMul))
+      return TExprEntry<T, E>::Avx2(e, res, n);
+    if (level >= SIMD_SSE2 && (!E::usesMul || TSse2<T>::hasMul))
+      return TExprEntry<T, E>::Sse2(e, res, n);
+  }
+#endif
+  for (size_t i = 0; i < n; i++)
+    res[i] = e[i];
+}
+
+// данные узла n длины sz: лист - собственный буфер, иначе узел
+// вычисляется в tmp
+template<typename T, typename N>
+const T* ExprData(const N& n, size_t sz, std::vector<T>& tmp)
+{
+  if constexpr (std::is_same<N, TExprLeaf<T>>::value)
+    return n.p;
+  else
+  {
+    tmp.resize(sz);
+    EvalExpr(n, tmp.data(), sz);
+    return tmp.data();
+  }
+}
+
+// Узел операнда: ExprNode(v) для векторов и векторных выражений,
+// ExprMatrixNode(m, Layout()) для матриц и матричных выражений
+// с порядком хранения Layout (перегрузки для TDynamicVector и
+// TDynamicMatrix - в tmatrix.h)
+template<typename U, typename T>
+using TVectorNode = typename std::enable_if<
+  std::is_same<typename std::decay<decltype(ExprNode(std::declval<const U&>()))>::type::value_type, T>::value,
+  typename std::decay<decltype(ExprNode(std::declval<const U&>()))>::type>::type;
+template<typename U, typename T, typename Layout>
+using TMatrixNode = typename std::enable_if<
+  std::is_same<typename std::decay<decltype(ExprMatrixNode(std::declval<const U&>(), Layout()))>::type::value_type, T>::value,
+  typename std::decay<decltype(ExprMatrixNode(std::declval<const U&>(), Layout()))>::type>::type;
+
+// Векторное выражение длины sz
+template<typename T, typename E>
+class TVectorExpr
+{
+  E e;
+  size_t sz;
+
+  template<typename Op, typename N>
+  TVectorExpr<T, TExprBinary<Op, E, N>> Combine(const N& n) const
+  {
+    return TVectorExpr<T, TExprBinary<Op, E, N>>(TExprBinary<Op, E, N>(e, n), sz);
+  }
+public:
+  using value_type = T;
+
+  TVectorExpr(const E& node, size_t size) : e(node), sz(size) {}
+
+  size_t size() const noexcept { return sz; }
+  const E& node() const noexcept { return e; }
+  T operator[](size_t ind) const { return e[ind]; }
+  void EvalTo(T* res) const { EvalExpr(e, res, sz); }
+
+  // скалярные операции
+  TVectorExpr<T, TExprBinary<TExprAdd, E, TExprScalar<T>>> operator+(const T& val) const
+  {
+    return Combine<TExprAdd>(TExprScalar<T>(val));
+  }
+  TVectorExpr<T, TExprBinary<TExprSub, E, TExprScalar<T>>> operator-(const T& val) const
+  {
+    return Combine<TExprSub>(TExprScalar<T>(val));
+  }
+  TVectorExpr<T, TExprBinary<TExprMul, E, TExprScalar<T>>> operator*(const T& val) const
+  {
+    return Combine<TExprMul>(TExprScalar<T>(val));
+  }
+
+  // векторные операции: U - вектор или векторное выражение
+  template<typename U, typename N = TVectorNode<U, T>>
+  TVectorExpr<T, TExprBinary<TExprAdd, E, N>> operator+(const U& v) const
+  {
+    if (sz != v.size())
+      throw std::length_error("Vectors should have equal sizes");
+    return Combine<TExprAdd>(N(ExprNode(v)));
+  }
+  template<typename U, typename N = TVectorNode<U, T>>
+  TVectorExpr<T, TExprBinary<TExprSub, E, N>> operator-(const U& v) const
+  {
+    if (sz != v.size())
+      throw std::length_error("Vectors should have equal sizes");
+    return Combine<TExprSub>(N(ExprNode(v)));
+  }
+  // скалярное произведение; выражения вычисляются во временные буферы
+  template<typename U, typename N = TVectorNode<U, T>>
+  T operator*(const U& v) const
+  {
+    if (sz != v.size())
+      throw std::length_error("Vectors should have equal sizes");
+    std::vector<T> x, y;
+    return simd_dot(ExprData(e, sz, x), ExprData(N(ExprNode(v)), sz, y), sz);
+  }
+
+  // сравнение без вычисления в буфер
+  template<typename U, typename N = TVectorNode<U, T>>
+  bool operator==(const U& v) const
+  {
+    if (sz != v.size())
+      return false;
+    const N n = ExprNode(v);
+    for (size_t i = 0; i < sz; i++)
+      if (!(e[i] == n[i]))
+        return false;
+    return true;
+  }
+  template<typename U, typename N = TVectorNode<U, T>>
+  bool operator!=(const U& v) const
+  {
+    return !(*this == v);
+  }
+
+  friend std::ostream& operator<<(std::ostream& ostr, const TVectorExpr& v)
+  {
+    for (size_t i = 0; i < v.sz; i++)
+      ostr << v[i] << ' ';
+    return ostr;
+  }
+};
+
+template<typename T, typename E>
+const E& ExprNode(const TVectorExpr<T, E>& v) noexcept
+{
+  return v.node();
+}
+
+// Строка матричного выражения: элемент [j] вычисляется при обращении
+template<typename T, typename E>
+class TExprRow
+{
+  E e;
+  size_t first, step, sz;
+public:
+  TExprRow(const E& node, size_t offset, size_t stride, size_t size) : e(node), first(offset), step(stride), sz(size) {}
+
+  size_t size() const noexcept { return sz; }
+  T operator[](size_t ind) const { return e[first + ind * step]; }
+};
+
+// Матричное выражение rows x cols: узлы обходят буфер подряд, поэтому
+// операнды имеют один порядок хранения Layout
+template<typename T, typename E, typename Layout>
+class TMatrixExpr
+{
+  E e;
+  size_t nrows, ncols;
+
+  template<typename Op, typename N>
+  TMatrixExpr<T, TExprBinary<Op, E, N>, Layout> Combine(const N& n) const
+  {
+    return TMatrixExpr<T, TExprBinary<Op, E, N>, Layout>(TExprBinary<Op, E, N>(e, n), nrows, ncols);
+  }
+public:
+  using value_type = T;
+
+  TMatrixExpr(const E& node, size_t r, size_t c) : e(node), nrows(r), ncols(c) {}
+
+  size_t size() const noexcept { return nrows; }
+  size_t rows() const noexcept { return nrows; }
+  size_t cols() const noexcept { return ncols; }
+  const E& node() const noexcept { return e; }
+  // индексация: строка i, m[i][j] без контроля
+  TExprRow<T, E> operator[](size_t ind) const
+  {
+    if (std::is_same<Layout, TRowMajor>::value)
+      return TExprRow<T, E>(e, ind * ncols, 1, ncols);
+    return TExprRow<T, E>(e, ind, nrows, ncols);
+  }
+  T at(size_t i, size_t j) const
+  {
+    if (i >= nrows || j >= ncols)
+      throw std::out_of_range("Matrix index is out of range");
+    return e[std::is_same<Layout, TRowMajor>::value ? i * ncols + j : j * nrows + i];
+  }
+  void EvalTo(T* res) const { EvalExpr(e, res, nrows * ncols); }
+
+  // матрично-скалярные операции
+  TMatrixExpr<T, TExprBinary<TExprMul, E, TExprScalar<T>>, Layout> operator*(const T& val) const
+  {
+    return Combine<TExprMul>(TExprScalar<T>(val));
+  }
+
+  // матрично-матричные операции: U - матрица или матричное выражение
+  template<typename U, typename N = TMatrixNode<U, T, Layout>>
+  TMatrixExpr<T, TExprBinary<TExprAdd, E, N>, Layout> operator+(const U& m) const
+  {
+    if (nrows != m.rows() || ncols != m.cols())
+      throw std::length_error("Matrices should have equal sizes");
+    return Combine<TExprAdd>(N(ExprMatrixNode(m, Layout())));
+  }
+  template<typename U, typename N = TMatrixNode<U, T, Layout>>
+  TMatrixExpr<T, TExprBinary<TExprSub, E, N>, Layout> operator-(const U& m) const
+  {
+    if (nrows != m.rows() || ncols != m.cols())
+      throw std::length_error("Matrices should have equal sizes");
+    return Combine<TExprSub>(N(ExprMatrixNode(m, Layout())));
+  }
+
+  // сравнение без вычисления в буфер
+  template<typename U, typename N = TMatrixNode<U, T, Layout>>
+  bool operator==(const U& m) const
+  {
+    if (nrows != m.rows() || ncols != m.cols())
+      return false;
+    const N n = ExprMatrixNode(m, Layout());
+    for (size_t k = 0; k < nrows * ncols; k++)
+      if (!(e[k] == n[k]))
+        return false;
+    return true;
+  }
+  template<typename U, typename N = TMatrixNode<U, T, Layout>>
+  bool operator!=(const U& m) const
+  {
+    return !(*this == m);
+  }
+
+  friend std::ostream& operator<<(std::ostream& ostr, const TMatrixExpr& m)
+  {
+    for (size_t i = 0; i < m.nrows; i++)
+    {
+      for (size_t j = 0; j < m.ncols; j++)
+        ostr << m.at(i, j) << ' ';
+      ostr << std::endl;
+    }
+    return ostr;
+  }
+};
+
+template<typename T, typename E, typename Layout>
+const E& ExprMatrixNode(const TMatrixExpr<T, E, Layout>& m, Layout) noexcept
+{
+  return m.node();
+}
+
+// признак выражения (результат, который нужно вычислить)
+template<typename U>
+struct TIsExpr : std::false_type {};
+template<typename T, typename E>
+struct TIsExpr<TVectorExpr<T, E>> : std::true_type {};
+template<typename T, typename E, typename Layout>
+struct TIsExpr<TMatrixExpr<T, E, Layout>> : std::true_type {};
+
+#endif
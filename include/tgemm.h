@@ -0,0 +1,505 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TGemm_H__
+#define __TGemm_H__
+
+#include <algorithm>
+#include <vector>
+#include "tallocator.h"
+#include "tsimd.h"
+
+// Блочное умножение матриц C += A * B (схема GotoBLAS/BLIS).
+// Матрицы хранятся построчно с ведущими размерностями lda, ldb, ldc.
+// Циклы по блокам: столбцы C полосами по nc, общий размер панелями по kc
+// (панель B kc x nc упаковывается и живет в L3), строки блоками по mc
+// (блок A mc x kc упаковывается и живет в L2). Внутри - микроядро mr x nr,
+// которое держит блок C в регистрах и читает упакованные A и B подряд
+
+// Размеры блоков в элементах; по умолчанию - под L1 32 КБ, L2 от 256 КБ
+struct TGemmBlocking
+{
+  size_t mc, kc, nc;
+};
+
+inline TGemmBlocking& gemm_blocking()
+{
+  static TGemmBlocking blocking = { 120, 256, 4096 };
+  return blocking;
+}
+
+// произведения меньшего объема (m * n * k) считаются простым циклом i-k-j
+const size_t GEMM_SMALL_VOLUME = 32 * 32 * 32;
+
+// "регистр" из одного элемента - микроядро для произвольного T
+template<typename T>
+struct TScalarReg
+{
+  using reg = T;
+  static constexpr size_t width = 1;
+  static constexpr bool hasMul = true;
+  // базовый набор x86-64: атрибут ядра не меняет кода
+  static constexpr const char isa[] = "sse2";
+  static reg load(const T* p) { return *p; }
+  static void store(T* p, reg a) { *p = a; }
+  static reg add(reg a, reg b) { return a + b; }
+  static reg mul(reg a, reg b) { return a * b; }
+  static reg fma(reg a, reg b, reg c) { return a * b + c; }
+  static reg set1(T a) { return a; }
+  static reg zero() { return T(); }
+};
+
+// Упаковка, микроядро и обход блоков над регистрами V
+template<typename V, typename T>
+struct TGemmKernel
+{
+  // микроблок: nr - два регистра по столбцам; mr строк - сколько
+  // помещается в регистровый файл вместе с накопителями
+  static constexpr size_t nr = V::width == 1 ? 4 : 2 * V::width;
+  static constexpr size_t mr = V::width == 1 ? 4 : sizeof(typename V::reg) == 64 ? 8 : 6;
+  static constexpr size_t nv = nr / V::width;
+
+  // блок A rows x kc -> полосы по mr строк, внутри полосы - по столбцам
+  MP2_KERNEL(V) static void PackA(const T* a, size_t lda, size_t rows, size_t kc, T* ap)
+  {
+    for (size_t i0 = 0; i0 < rows; i0 += mr)
+    {
+      const size_t r = std::min(mr, rows - i0);
+      for (size_t p = 0; p < kc; p++)
+      {
+        for (size_t i = 0; i < r; i++)
+          ap[i] = a[(i0 + i) * lda + p];
+        for (size_t i = r; i < mr; i++)
+          ap[i] = T();
+        ap += mr;
+      }
+    }
+  }
+  // панель B kc x cols -> полосы по nr столбцов, внутри полосы - по строкам
+  MP2_KERNEL(V) static void PackB(const T* b, size_t ldb, size_t kc, size_t cols, T* bp)
+  {
+    for (size_t j0 = 0; j0 < cols; j0 += nr)
+    {
+      const size_t c = std::min(nr, cols - j0);
+      for (size_t p = 0; p < kc; p++)
+      {
+        const T* brow = b + p * ldb + j0;
+        for (size_t j = 0; j < c; j++)
+          bp[j] = brow[j];
+        for (size_t j = c; j < nr; j++)
+          bp[j] = T();
+        bp += nr;
+      }
+    }
+  }
+
+  // C[0..r) x [0..c) += Ap * Bp по kc; r <= mr, c <= nr
+  MP2_KERNEL(V) static void MicroKernel(size_t kc, const T* ap, const T* bp, T* c, size_t ldc, size_t r, size_t cn)
+  {
+    typename V::reg acc[mr][nv];
+    for (size_t i = 0; i < mr; i++)
+      for (size_t j = 0; j < nv; j++)
+        acc[i][j] = V::zero();
+    for (size_t p = 0; p < kc; p++)
+    {
+      typename V::reg bv[nv];
+      for (size_t j = 0; j < nv; j++)
+        bv[j] = V::load(bp + j * V::width);
+      for (size_t i = 0; i < mr; i++)
+      {
+        const typename V::reg av = V::set1(ap[i]);
+        for (size_t j = 0; j < nv; j++)
+          acc[i][j] = V::fma(av, bv[j], acc[i][j]);
+      }
+      ap += mr;
+      bp += nr;
+    }
+    if (r == mr && cn == nr)
+      for (size_t i = 0; i < mr; i++)
+        for (size_t j = 0; j < nv; j++)
+        {
+          T* cp = c + i * ldc + j * V::width;
+          V::store(cp, V::add(V::load(cp), acc[i][j]));
+        }
+    else
+    {
+      T tmp[mr * nr];
+      for (size_t i = 0; i < mr; i++)
+        for (size_t j = 0; j < nv; j++)
+          V::store(tmp + i * nr + j * V::width, acc[i][j]);
+      for (size_t i = 0; i < r; i++)
+        for (size_t j = 0; j < cn; j++)
+          c[i * ldc + j] += tmp[i * nr + j];
+    }
+  }
+
+  MP2_KERNEL(V) static void Run(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc)
+  {
+    const TGemmBlocking bl = gemm_blocking();
+    const size_t mc = std::max<size_t>(1, std::min(bl.mc, m)), kc = std::max<size_t>(1, std::min(bl.kc, k));
+    const size_t nc = std::max<size_t>(1, std::min(bl.nc, n));
+    std::vector<T, TAlignedAllocator<T>> ap((mc + mr - 1) / mr * mr * kc), bp((nc + nr - 1) / nr * nr * kc);
+    for (size_t jc = 0; jc < n; jc += nc)
+    {
+      const size_t ncur = std::min(nc, n - jc);
+      for (size_t pc = 0; pc < k; pc += kc)
+      {
+        const size_t kcur = std::min(kc, k - pc);
+        PackB(b + pc * ldb + jc, ldb, kcur, ncur, bp.data());
+        for (size_t ic = 0; ic < m; ic += mc)
+        {
+          const size_t mcur = std::min(mc, m - ic);
+          PackA(a + ic * lda + pc, lda, mcur, kcur, ap.data());
+          for (size_t jr = 0; jr < ncur; jr += nr)
+            for (size_t ir = 0; ir < mcur; ir += mr)
+              MicroKernel(kcur, ap.data() + ir * kcur, bp.data() + jr * kcur,
+                c + (ic + ir) * ldc + jc + jr, ldc, std::min(mr, mcur - ir), std::min(nr, ncur - jr));
+        }
+      }
+    }
+  }
+};
+
+#ifdef MP2_SIMD_X86
+// входы уровней: обход, упаковка и микроядро собираются под набор уровня;
+// уровни без векторного умножения для T не вызываются
+template<typename T>
+struct TGemmEntry
+{
+  MP2_SIMD_ENTRY("sse2") static void Sse2(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc)
+  {
+    if constexpr (TSse2<T>::hasMul)
+      TGemmKernel<TSse2<T>, T>::Run(m, n, k, a, lda, b, ldb, c, ldc);
+  }
+  MP2_SIMD_ENTRY("avx2,fma") static void Avx2(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc)
+  {
+    if constexpr (TAvx2<T>::hasMul)
+      TGemmKernel<TAvx2<T>, T>::Run(m, n, k, a, lda, b, ldb, c, ldc);
+  }
+  MP2_SIMD_ENTRY("avx512f,avx512dq") static void Avx512(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc)
+  {
+    if constexpr (TAvx512<T>::hasMul)
+      TGemmKernel<TAvx512<T>, T>::Run(m, n, k, a, lda, b, ldb, c, ldc);
+  }
+};
+#endif
+
+// C (m x n) += A (m x k) * B (k x n)
+template<typename T>
+void gemm(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc)
+{
+  if (m * n * k <= GEMM_SMALL_VOLUME)
+  {
+    // порядок i-k-j: внутренний цикл идет по строкам C и B подряд
+    for (size_t i = 0; i < m; i++)
+      for (size_t p = 0; p < k; p++)
+      {
+        const T aip = a[i * lda + p];
+        const T* brow = b + p * ldb;
+        T* crow = c + i * ldc;
+        for (size_t j = 0; j < n; j++)
+          crow[j] += aip * brow[j];
+      }
+    return;
+  }
+#ifdef MP2_SIMD_X86
+  if constexpr (TIsSimdType<T>::value)
+  {
+    // уровень без векторного умножения для T пропускается
+    const TSimdLevel level = simd_level();
+    if (level >= SIMD_AVX512 && TAvx512<T>::hasMul)
+      return TGemmEntry<T>::Avx512(m, n, k, a, lda, b, ldb, c, ldc);
+    if (level >= SIMD_AVX2 && TAvx2<T>::hasMul)
+      return TGemmEntry<T>::Avx2(m, n, k, a, lda, b, ldb, c, ldc);
+    if (level >= SIMD_SSE2 && TSse2<T>::hasMul)
+      return TGemmEntry<T>::Sse2(m, n, k, a, lda, b, ldb, c, ldc);
+  }
+#endif
+  TGemmKernel<TScalarReg<T>, T>::Run(m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+// число элементов в буферах упаковки, которые выделяет gemm(m, n, k):
+// оценка сверху для любого уровня (mr не больше 8, nr - два регистра AVX-512)
+template<typename T>
+size_t gemm_workspace(size_t m, size_t n, size_t k)
+{
+  if (m * n * k <= GEMM_SMALL_VOLUME)
+    return 0;
+  const TGemmBlocking bl = gemm_blocking();
+  const size_t mc = std::max<size_t>(1, std::min(bl.mc, m)), kc = std::max<size_t>(1, std::min(bl.kc, k));
+  const size_t nc = std::max<size_t>(1, std::min(bl.nc, n));
+  const size_t mr = 8, nr = std::max<size_t>(4, 128 / sizeof(T));
+  return ((mc + mr - 1) / mr * mr + (nc + nr - 1) / nr * nr) * kc;
+}
+
+// Умножение Штрассена - Винограда: 7 умножений половинных блоков и
+// 15 сложений на уровень. Рекурсия идет, пока все размеры не меньше
+// strassen_crossover(), ниже - блочный gemm. Нечетные размеры
+// отщепляются: четная часть считается рекурсивно, последние строка,
+// столбец и слагаемое по k добавляются через gemm. Промежуточные блоки
+// всех уровней берутся из одного буфера, выделяемого один раз
+inline size_t& strassen_crossover()
+{
+  static size_t crossover = 1024;
+  return crossover;
+}
+
+template<typename T>
+struct TStrassen
+{
+  static bool Split(size_t m, size_t n, size_t k)
+  {
+    return std::min(m, std::min(n, k)) >= std::max<size_t>(2, strassen_crossover());
+  }
+  // размер буфера для произведения m x k на k x n
+  static size_t WorkSize(size_t m, size_t n, size_t k)
+  {
+    if (!Split(m, n, k))
+      return 0;
+    const size_t m2 = m / 2, n2 = n / 2, k2 = k / 2;
+    return m2 * k2 + k2 * n2 + m2 * n2 + WorkSize(m2, n2, k2);
+  }
+
+  static void Add(size_t r, size_t c, const T* x, size_t ldx, const T* y, size_t ldy, T* z, size_t ldz)
+  {
+    for (size_t i = 0; i < r; i++)
+      simd_add(x + i * ldx, y + i * ldy, z + i * ldz, c);
+  }
+  static void Sub(size_t r, size_t c, const T* x, size_t ldx, const T* y, size_t ldy, T* z, size_t ldz)
+  {
+    for (size_t i = 0; i < r; i++)
+      simd_sub(x + i * ldx, y + i * ldy, z + i * ldz, c);
+  }
+  static void Zero(size_t r, size_t c, T* z, size_t ldz)
+  {
+    for (size_t i = 0; i < r; i++)
+      std::fill(z + i * ldz, z + i * ldz + c, T());
+  }
+
+  // C = A * B
+  static void Multiply(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb,
+    T* c, size_t ldc, T* work)
+  {
+    if (!Split(m, n, k))
+    {
+      Zero(m, n, c, ldc);
+      gemm(m, n, k, a, lda, b, ldb, c, ldc);
+      return;
+    }
+    const size_t m2 = m / 2, n2 = n / 2, k2 = k / 2;
+    const T *a11 = a, *a12 = a + k2, *a21 = a + m2 * lda, *a22 = a21 + k2;
+    const T *b11 = b, *b12 = b + n2, *b21 = b + k2 * ldb, *b22 = b21 + n2;
+    T *c11 = c, *c12 = c + n2, *c21 = c + m2 * ldc, *c22 = c21 + n2;
+    T *x = work, *y = x + m2 * k2, *z = y + k2 * n2, *next = z + m2 * n2;
+
+    // порядок вычислений обходится тремя временными блоками:
+    // x = S, y = T, z = P1, остальные произведения - в четвертях C
+    Sub(m2, k2, a11, lda, a21, lda, x, k2);            // S3 = A11 - A21
+    Sub(k2, n2, b22, ldb, b12, ldb, y, n2);            // T3 = B22 - B12
+    Multiply(m2, n2, k2, x, k2, y, n2, c21, ldc, next); // P7 = S3 T3
+    Add(m2, k2, a21, lda, a22, lda, x, k2);            // S1 = A21 + A22
+    Sub(k2, n2, b12, ldb, b11, ldb, y, n2);            // T1 = B12 - B11
+    Multiply(m2, n2, k2, x, k2, y, n2, c22, ldc, next); // P5 = S1 T1
+    Sub(m2, k2, x, k2, a11, lda, x, k2);               // S2 = S1 - A11
+    Sub(k2, n2, b22, ldb, y, n2, y, n2);               // T2 = B22 - T1
+    Multiply(m2, n2, k2, x, k2, y, n2, c12, ldc, next); // P6 = S2 T2
+    Sub(m2, k2, a12, lda, x, k2, x, k2);               // S4 = A12 - S2
+    Multiply(m2, n2, k2, x, k2, b22, ldb, c11, ldc, next); // P3 = S4 B22
+    Multiply(m2, n2, k2, a11, lda, b11, ldb, z, n2, next); // P1 = A11 B11
+    Add(m2, n2, z, n2, c12, ldc, c12, ldc);            // U2 = P1 + P6
+    Add(m2, n2, c12, ldc, c21, ldc, c21, ldc);         // U3 = U2 + P7
+    Add(m2, n2, c12, ldc, c22, ldc, c12, ldc);         // U4 = U2 + P5
+    Add(m2, n2, c21, ldc, c22, ldc, c22, ldc);         // C22 = U3 + P5
+    Add(m2, n2, c12, ldc, c11, ldc, c12, ldc);         // C12 = U4 + P3
+    Sub(k2, n2, y, n2, b21, ldb, y, n2);               // T4 = T2 - B21
+    Multiply(m2, n2, k2, a22, lda, y, n2, c11, ldc, next); // P4 = A22 T4
+    Sub(m2, n2, c21, ldc, c11, ldc, c21, ldc);         // C21 = U3 - P4
+    Multiply(m2, n2, k2, a12, lda, b21, ldb, c11, ldc, next); // P2 = A12 B21
+    Add(m2, n2, z, n2, c11, ldc, c11, ldc);            // C11 = P1 + P2
+
+    // отщепленные строка, столбец и слагаемое по k
+    const size_t me = 2 * m2, ne = 2 * n2, ke = 2 * k2;
+    if (ke != k)
+      gemm(me, ne, 1, a + ke, lda, b + ke * ldb, ldb, c, ldc);
+    if (ne != n)
+    {
+      Zero(me, 1, c + ne, ldc);
+      gemm(me, 1, k, a, lda, b + ne, ldb, c + ne, ldc);
+    }
+    if (me != m)
+    {
+      Zero(1, n, c + me * ldc, ldc);
+      gemm(1, n, k, a + me * lda, lda, b, ldb, c + me * ldc, ldc);
+    }
+  }
+};
+
+// C (m x n) = A (m x k) * B (k x n)
+template<typename T>
+void strassen(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc)
+{
+  std::vector<T, TAlignedAllocator<T>> work(TStrassen<T>::WorkSize(m, n, k));
+  TStrassen<T>::Multiply(m, n, k, a, lda, b, ldb, c, ldc, work.data());
+}
+
+// Умножение матрицы на вектор (GEMV). Скорость ограничена чтением
+// матрицы из памяти, поэтому каждый элемент A читается ровно один раз:
+// - gemv: y = A x - за проход по строкам обрабатываются GEMV_ROWS строк
+//   сразу, кусок x из регистра умножается на все строки;
+// - gemv_t: y = x^T A - без транспонирования: y накапливается суммой
+//   строк A с коэффициентами x[i], тоже по GEMV_ROWS строк за проход.
+// Строки A читаются с программной предвыборкой на GEMV_PREFETCH байт вперед,
+// произведения накапливаются через fma
+const size_t GEMV_ROWS = 4;
+const size_t GEMV_PREFETCH = 512;
+
+inline void Prefetch(const void* p) noexcept
+{
+#if defined(_MSC_VER) && defined(MP2_SIMD_X86)
+  _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#elif defined(__GNUC__)
+  __builtin_prefetch(p);
+#else
+  (void)p;
+#endif
+}
+
+template<typename V, typename T>
+struct TGemvKernel
+{
+  static constexpr size_t ahead = GEMV_PREFETCH / sizeof(T);
+
+  // y[0..R) = строки a[0..R) * x
+  template<size_t R>
+  MP2_KERNEL(V) static void RowBlock(size_t n, const T* a, size_t lda, const T* x, T* y)
+  {
+    typename V::reg acc[R];
+    for (size_t r = 0; r < R; r++)
+      acc[r] = V::zero();
+    size_t j = 0;
+    for (; j + V::width <= n; j += V::width)
+    {
+      const typename V::reg xv = V::load(x + j);
+      for (size_t r = 0; r < R; r++)
+      {
+        if constexpr (V::width > 1)
+          Prefetch(a + r * lda + j + ahead);
+        acc[r] = V::fma(V::load(a + r * lda + j), xv, acc[r]);
+      }
+    }
+    for (size_t r = 0; r < R; r++)
+    {
+      T lanes[V::width];
+      V::store(lanes, acc[r]);
+      T sum = T();
+      for (size_t k = 0; k < V::width; k++)
+        sum += lanes[k];
+      for (size_t jj = j; jj < n; jj++)
+        sum += a[r * lda + jj] * x[jj];
+      y[r] = sum;
+    }
+  }
+  MP2_KERNEL(V) static void Rows(size_t m, size_t n, const T* a, size_t lda, const T* x, T* y)
+  {
+    size_t i = 0;
+    for (; i + GEMV_ROWS <= m; i += GEMV_ROWS)
+      RowBlock<GEMV_ROWS>(n, a + i * lda, lda, x, y + i);
+    for (; i < m; i++)
+      RowBlock<1>(n, a + i * lda, lda, x, y + i);
+  }
+
+  // y += x[0..R) * строки a[0..R)
+  template<size_t R>
+  MP2_KERNEL(V) static void ColBlock(size_t n, const T* a, size_t lda, const T* x, T* y)
+  {
+    typename V::reg xv[R];
+    for (size_t r = 0; r < R; r++)
+      xv[r] = V::set1(x[r]);
+    size_t j = 0;
+    for (; j + V::width <= n; j += V::width)
+    {
+      typename V::reg sum = V::load(y + j);
+      for (size_t r = 0; r < R; r++)
+      {
+        if constexpr (V::width > 1)
+          Prefetch(a + r * lda + j + ahead);
+        sum = V::fma(xv[r], V::load(a + r * lda + j), sum);
+      }
+      V::store(y + j, sum);
+    }
+    for (; j < n; j++)
+      for (size_t r = 0; r < R; r++)
+        y[j] += x[r] * a[r * lda + j];
+  }
+  MP2_KERNEL(V) static void Cols(size_t m, size_t n, const T* a, size_t lda, const T* x, T* y)
+  {
+    std::fill(y, y + n, T());
+    size_t i = 0;
+    for (; i + GEMV_ROWS <= m; i += GEMV_ROWS)
+      ColBlock<GEMV_ROWS>(n, a + i * lda, lda, x + i, y);
+    for (; i < m; i++)
+      ColBlock<1>(n, a + i * lda, lda, x + i, y);
+  }
+};
+
+#ifdef MP2_SIMD_X86
+template<typename T>
+struct TGemvEntry
+{
+  MP2_SIMD_ENTRY("sse2") static void Sse2(bool trans, size_t m, size_t n, const T* a, size_t lda, const T* x, T* y)
+  {
+    if constexpr (TSse2<T>::hasMul)
+      trans ? TGemvKernel<TSse2<T>, T>::Cols(m, n, a, lda, x, y) : TGemvKernel<TSse2<T>, T>::Rows(m, n, a, lda, x, y);
+  }
+  MP2_SIMD_ENTRY("avx2,fma") static void Avx2(bool trans, size_t m, size_t n, const T* a, size_t lda, const T* x, T* y)
+  {
+    if constexpr (TAvx2<T>::hasMul)
+      trans ? TGemvKernel<TAvx2<T>, T>::Cols(m, n, a, lda, x, y) : TGemvKernel<TAvx2<T>, T>::Rows(m, n, a, lda, x, y);
+  }
+  MP2_SIMD_ENTRY("avx512f,avx512dq") static void Avx512(bool trans, size_t m, size_t n, const T* a, size_t lda, const T* x, T* y)
+  {
+    if constexpr (TAvx512<T>::hasMul)
+      trans ? TGemvKernel<TAvx512<T>, T>::Cols(m, n, a, lda, x, y) : TGemvKernel<TAvx512<T>, T>::Rows(m, n, a, lda, x, y);
+  }
+};
+#endif
+
+template<typename T>
+void Gemv(bool trans, size_t m, size_t n, const T* a, size_t lda, const T* x, T* y)
+{
+#ifdef MP2_SIMD_X86
+  if constexpr (TIsSimdType<T>::value)
+  {
+    const TSimdLevel level = simd_level();
+    if (level >= SIMD_AVX512 && TAvx512<T>::hasMul)
+      return TGemvEntry<T>::Avx512(trans, m, n, a, lda, x, y);
+    if (level >= SIMD_AVX2 && TAvx2<T>::hasMul)
+      return TGemvEntry<T>::Avx2(trans, m, n, a, lda, x, y);
+    if (level >= SIMD_SSE2 && TSse2<T>::hasMul)
+      return TGemvEntry<T>::Sse2(trans, m, n, a, lda, x, y);
+  }
+#endif
+  if (trans)
+    TGemvKernel<TScalarReg<T>, T>::Cols(m, n, a, lda, x, y);
+  else
+    TGemvKernel<TScalarReg<T>, T>::Rows(m, n, a, lda, x, y);
+}
+
+// y (m) = A (m x n) * x (n)
+template<typename T>
+void gemv(size_t m, size_t n, const T* a, size_t lda, const T* x, T* y)
+{
+  Gemv(false, m, n, a, lda, x, y);
+}
+
+// y (n) = x (m) * A (m x n)
+template<typename T>
+void gemv_t(size_t m, size_t n, const T* a, size_t lda, const T* x, T* y)
+{
+  Gemv(true, m, n, a, lda, x, y);
+}
+
+#endif
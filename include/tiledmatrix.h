@@ -0,0 +1,286 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TTiledMatrix_H__
+#define __TTiledMatrix_H__
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "tmatrix.h"
+
+const char TILED_MATRIX_MAGIC[8] = { 'M', 'P', '2', 'T', 'I', 'L', 'E', '\0' };
+
+struct TTiledMatrixHeader
+{
+  char magic[8];
+  uint64_t rows, cols;
+  uint64_t tile;
+  uint64_t elemSize;
+  uint64_t reserved[3];
+};
+static_assert(sizeof(TTiledMatrixHeader) == 64, "Tiled matrix header should take 64 bytes");
+
+// Матрица на диске, разбитая на плитки tile x tile -
+// для матриц, не помещающихся в память (размеры не ограничены
+// MAX_MATRIX_SIZE). Файл: заголовок из 64 байт, затем плитки по строкам
+// сетки плиток, каждая плитка - tile * tile элементов построчно.
+// Крайние плитки дополняются нулями. В памяти одновременно находятся
+// лишь несколько плиток (при умножении - полос плиток в пределах бюджета)
+template<typename T>
+class TTiledMatrix
+{
+  static_assert(is_trivially_copyable<T>::value, "Tiled matrix requires trivially copyable elements");
+
+  size_t nrows, ncols, tsz;
+  size_t ntrows, ntcols;
+  string fname;
+  mutable fstream file;
+
+  static size_t CheckedTile(size_t r, size_t c, size_t tile)
+  {
+    if (r == 0 || c == 0 || tile == 0)
+      throw out_of_range("Matrix and tile sizes should be greater than zero");
+    if (tile > MAX_MATRIX_SIZE || tile > MAX_MATRIX_ELEMENTS / tile)
+      throw out_of_range("Tile size should not exceed MAX_MATRIX_SIZE");
+    return tile;
+  }
+
+  size_t TileElements() const noexcept { return tsz * tsz; }
+
+  void Seek(size_t ti, size_t tj) const
+  {
+    if (ti >= ntrows || tj >= ntcols)
+      throw out_of_range("Tile index is out of range");
+    const uint64_t pos = sizeof(TTiledMatrixHeader) + (uint64_t(ti) * ntcols + tj) * TileElements() * sizeof(T);
+    file.clear();
+    file.seekg(streamoff(pos));
+    file.seekp(streamoff(pos));
+  }
+public:
+  // новый файл path с нулевой матрицей r x c
+  TTiledMatrix(const string& path, size_t r, size_t c, size_t tile)
+    : nrows(r), ncols(c), tsz(CheckedTile(r, c, tile)), ntrows((r + tile - 1) / tile),
+    ntcols((c + tile - 1) / tile), fname(path)
+  {
+    TTiledMatrixHeader h{};
+    memcpy(h.magic, TILED_MATRIX_MAGIC, sizeof(h.magic));
+    h.rows = r;
+    h.cols = c;
+    h.tile = tile;
+    h.elemSize = sizeof(T);
+    {
+      ofstream f(path, ios::binary | ios::trunc);
+      f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+      if (!f)
+        throw runtime_error("Cannot create matrix file " + path);
+    }
+    // плитки заполняются нулями без записи (разреженный файл, где возможно)
+    filesystem::resize_file(path, sizeof(h) + uint64_t(ntrows) * ntcols * TileElements() * sizeof(T));
+    file.open(path, ios::binary | ios::in | ios::out);
+    if (!file)
+      throw runtime_error("Cannot open matrix file " + path);
+  }
+  // существующий файл path
+  explicit TTiledMatrix(const string& path) : fname(path), file(path, ios::binary | ios::in | ios::out)
+  {
+    TTiledMatrixHeader h;
+    if (!file.read(reinterpret_cast<char*>(&h), sizeof(h)))
+      throw runtime_error("Cannot read matrix file " + path);
+    if (memcmp(h.magic, TILED_MATRIX_MAGIC, sizeof(h.magic)) != 0 || h.elemSize != sizeof(T))
+      throw runtime_error("Matrix file " + path + " has wrong format or element type");
+    nrows = size_t(h.rows);
+    ncols = size_t(h.cols);
+    tsz = CheckedTile(nrows, ncols, size_t(h.tile));
+    ntrows = (nrows + tsz - 1) / tsz;
+    ntcols = (ncols + tsz - 1) / tsz;
+  }
+
+  size_t rows() const noexcept { return nrows; }
+  size_t cols() const noexcept { return ncols; }
+  size_t tile() const noexcept { return tsz; }
+  // размеры сетки плиток
+  size_t tile_rows() const noexcept { return ntrows; }
+  size_t tile_cols() const noexcept { return ntcols; }
+  const string& path() const noexcept { return fname; }
+
+  // чтение и запись плитки (ti, tj): буфер из tile * tile элементов
+  void read_tile(size_t ti, size_t tj, T* buf) const
+  {
+    Seek(ti, tj);
+    if (!file.read(reinterpret_cast<char*>(buf), streamsize(TileElements() * sizeof(T))))
+      throw runtime_error("Cannot read matrix file " + fname);
+  }
+  void write_tile(size_t ti, size_t tj, const T* buf)
+  {
+    Seek(ti, tj);
+    if (!file.write(reinterpret_cast<const char*>(buf), streamsize(TileElements() * sizeof(T))))
+      throw runtime_error("Cannot write matrix file " + fname);
+  }
+
+  // обмен с плотной матрицей в памяти (если она туда помещается)
+  void assign(TMatrixView<const T> m)
+  {
+    if (m.rows() != nrows || m.cols() != ncols)
+      throw length_error("Matrices should have equal sizes");
+    TDynamicVector<T> buf(TileElements());
+    for (size_t ti = 0; ti < ntrows; ti++)
+      for (size_t tj = 0; tj < ntcols; tj++)
+      {
+        // дополнение крайних плиток должно оставаться нулевым
+        fill(buf.data(), buf.data() + TileElements(), T());
+        for (size_t i = ti * tsz; i < min(nrows, (ti + 1) * tsz); i++)
+          for (size_t j = tj * tsz; j < min(ncols, (tj + 1) * tsz); j++)
+            buf[(i % tsz) * tsz + j % tsz] = m[i][j];
+        write_tile(ti, tj, buf.data());
+      }
+    file.flush();
+  }
+  TDynamicMatrix<T> dense() const
+  {
+    TDynamicMatrix<T> res(nrows, ncols, NO_INIT);
+    TDynamicVector<T> buf(TileElements(), NO_INIT);
+    for (size_t ti = 0; ti < ntrows; ti++)
+      for (size_t tj = 0; tj < ntcols; tj++)
+      {
+        read_tile(ti, tj, buf.data());
+        for (size_t i = ti * tsz; i < min(nrows, (ti + 1) * tsz); i++)
+          for (size_t j = tj * tsz; j < min(ncols, (tj + 1) * tsz); j++)
+            res[i][j] = buf[(i % tsz) * tsz + j % tsz];
+      }
+    return res;
+  }
+
+  // умножение вне памяти: результат записывается в новый файл path.
+  // В памяти держатся полосы плиток: ga строк плиток A (tile x K) и gb
+  // столбцов плиток B (K x tile); плитка C считается одним gemm по всему K.
+  // Полосы A читаются один раз, полосы B - по разу на группу строк A.
+  // Один поток ввода читает следующие группы полос, пока считаются текущие
+  // (по два буфера на A и на B). budget - объем памяти в байтах на все
+  // буферы: 2 * (ga + gb) полос, две плитки (накопитель C и чтение) и
+  // буферы упаковки gemm; ga берется наибольшим, gb - из остатка
+  TTiledMatrix multiply(const TTiledMatrix& m, const string& path, size_t budget) const
+  {
+    if (ncols != m.nrows || tsz != m.tsz)
+      throw length_error("Matrix sizes and tiles should be compatible");
+    const size_t nk = ntcols, kp = nk * tsz, panel = kp * tsz;
+    const size_t fixed = 2 * TileElements() + gemm_workspace<T>(tsz, tsz, kp);
+    const size_t avail = budget / sizeof(T);
+    if (avail < fixed || (avail - fixed) / 4 < panel)
+      throw length_error("Memory budget is too small for the tile size");
+    const size_t npanels = (avail - fixed) / panel / 2;
+    const size_t ga = min(ntrows, npanels - 1), gb = min(m.ntcols, npanels - ga);
+    const size_t ngb = (m.ntcols + gb - 1) / gb;
+    const size_t steps = (ntrows + ga - 1) / ga * ngb;
+
+    TTiledMatrix res(path, nrows, m.ncols, tsz);
+    vector<T> abuf[2] = { vector<T>(ga * panel), vector<T>(ga * panel) };
+    vector<T> bbuf[2] = { vector<T>(gb * panel), vector<T>(gb * panel) };
+    TDynamicVector<T> tmp(TileElements(), NO_INIT), acc(TileElements(), NO_INIT);
+
+    // шаг s - группа строк s / ngb и группа столбцов s % ngb;
+    // полосы B шага s - в буфере s % 2, полосы A группы g - в буфере g % 2
+    auto load = [&](size_t s)
+    {
+      const size_t ig = s / ngb, jg = s % ngb;
+      if (jg == 0)
+        for (size_t i = 0; i < ga && ig * ga + i < ntrows; i++)
+          for (size_t k = 0; k < nk; k++)
+          {
+            read_tile(ig * ga + i, k, tmp.data());
+            T* dst = abuf[ig % 2].data() + i * panel + k * tsz;
+            for (size_t r = 0; r < tsz; r++)
+              copy(tmp.data() + r * tsz, tmp.data() + (r + 1) * tsz, dst + r * kp);
+          }
+      for (size_t j = 0; j < gb && jg * gb + j < m.ntcols; j++)
+        for (size_t k = 0; k < nk; k++)
+          m.read_tile(k, jg * gb + j, bbuf[s % 2].data() + j * panel + k * TileElements());
+    };
+    auto compute = [&](size_t s)
+    {
+      const size_t ig = s / ngb, jg = s % ngb;
+      for (size_t i = 0; i < ga && ig * ga + i < ntrows; i++)
+        for (size_t j = 0; j < gb && jg * gb + j < m.ntcols; j++)
+        {
+          fill(acc.data(), acc.data() + TileElements(), T());
+          gemm(tsz, tsz, kp, abuf[ig % 2].data() + i * panel, kp, bbuf[s % 2].data() + j * panel, tsz, acc.data(), tsz);
+          res.write_tile(ig * ga + i, jg * gb + j, acc.data());
+        }
+    };
+
+    // поток ввода загружает шаг s, когда шаг s - 2 посчитан (его буфер B
+    // свободен; буфер A следующей группы освобождается еще раньше)
+    mutex mtx;
+    condition_variable cv;
+    size_t loaded = 0, done = 0;
+    bool stop = false;
+    exception_ptr error;
+    thread io([&]
+    {
+      try
+      {
+        for (size_t s = 0; s < steps; s++)
+        {
+          {
+            unique_lock<mutex> lock(mtx);
+            cv.wait(lock, [&] { return stop || s < done + 2; });
+            if (stop)
+              return;
+          }
+          load(s);
+          lock_guard<mutex> lock(mtx);
+          loaded = s + 1;
+          cv.notify_all();
+        }
+      }
+      catch (...)
+      {
+        lock_guard<mutex> lock(mtx);
+        error = current_exception();
+        cv.notify_all();
+      }
+    });
+    try
+    {
+      for (size_t s = 0; s < steps; s++)
+      {
+        {
+          unique_lock<mutex> lock(mtx);
+          cv.wait(lock, [&] { return loaded > s || error; });
+          if (loaded <= s)
+            rethrow_exception(error);
+        }
+        compute(s);
+        lock_guard<mutex> lock(mtx);
+        done = s + 1;
+        cv.notify_all();
+      }
+    }
+    catch (...)
+    {
+      {
+        lock_guard<mutex> lock(mtx);
+        stop = true;
+        cv.notify_all();
+      }
+      io.join();
+      throw;
+    }
+    io.join();
+    res.file.flush();
+    return res;
+  }
+};
+
+#endif
@@ -8,101 +8,396 @@
 #define __TDynamicMatrix_H__
 
 #include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+#include "tallocator.h"
+#include "tsimd.h"
+#include "tgemm.h"
+#include "texpr.h"
 
 using namespace std;
 
-const int MAX_VECTOR_SIZE = 100000000;
-const int MAX_MATRIX_SIZE = 10000;
+// Ограничения размеров задаются при сборке, например -DMP2_MAX_VECTOR_SIZE=...
+// MAX_MATRIX_SIZE - наибольшая сторона квадратной матрицы;
+// MAX_MATRIX_ELEMENTS - наибольшее число элементов матрицы любой формы
+#ifndef MP2_MAX_VECTOR_SIZE
+#define MP2_MAX_VECTOR_SIZE 100000000
+#endif
+#ifndef MP2_MAX_MATRIX_SIZE
+#define MP2_MAX_MATRIX_SIZE 10000
+#endif
+#ifndef MP2_MAX_MATRIX_ELEMENTS
+#define MP2_MAX_MATRIX_ELEMENTS (size_t(MP2_MAX_MATRIX_SIZE) * size_t(MP2_MAX_MATRIX_SIZE))
+#endif
+
+const size_t MAX_VECTOR_SIZE = MP2_MAX_VECTOR_SIZE;
+const size_t MAX_MATRIX_SIZE = MP2_MAX_MATRIX_SIZE;
+const size_t MAX_MATRIX_ELEMENTS = MP2_MAX_MATRIX_ELEMENTS;
+
+// Размер встроенного буфера вектора в байтах: короткие векторы
+// (до SMALL_VECTOR_BYTES / sizeof(T) элементов) не обращаются к куче
+const size_t SMALL_VECTOR_BYTES = 64;
+
+// Тег конструктора без инициализации: элементы тривиальных типов
+// не обнуляются, для остальных вызывается конструктор по умолчанию.
+// Применяется для результатов, которые сразу полностью перезаписываются
+struct TNoInit {};
+const TNoInit NO_INIT{};
+
+// Тег конструктора, принимающего чужой буфер во владение без копирования.
+// Элементы буфера должны быть сконструированы; по окончании владения
+// вызывается удалитель d(p), который сам отвечает и за деструкторы элементов.
+// Если конструктор выбросил исключение, буфер остается у вызывающего
+struct TAdopt {};
+const TAdopt ADOPT{};
+
+template<typename T> class TVectorView;
+template<typename T> class TMatrixView;
 
 // Динамический вектор - 
-// шаблонный вектор на динамической памяти
-template<typename T>
+// шаблонный вектор на динамической памяти.
+// Память выделяется аллокатором Alloc (по умолчанию - с выравниванием
+// на DEFAULT_ALIGNMENT байт), элементы конструируются в ней на месте.
+// Векторы не длиннее SmallSize хранятся во встроенном буфере объекта
+template<typename T, typename Alloc = TAlignedAllocator<T>,
+  size_t SmallSize = SMALL_VECTOR_BYTES / sizeof(T)>
 class TDynamicVector
 {
+  using alloc_traits = allocator_traits<Alloc>;
+
+  // встроенный буфер выровнен так же, как память аллокатора по умолчанию
+  static constexpr size_t inlineAlign = SmallSize == 0 || alignof(T) > DEFAULT_ALIGNMENT ? alignof(T) : DEFAULT_ALIGNMENT;
+
+  alignas(inlineAlign) unsigned char inlineMem[SmallSize ? SmallSize * sizeof(T) : 1];
 protected:
   size_t sz;
   T* pMem;
-public:
-  TDynamicVector(size_t size = 1) : sz(size)
+  Alloc alloc;
+  TBufferDeleter<T>* ext; // удалитель чужого буфера или nullptr
+
+  T* InlineMem() noexcept { return reinterpret_cast<T*>(inlineMem); }
+  bool IsInline() const noexcept { return pMem == reinterpret_cast<const T*>(inlineMem); }
+
+  // выделение памяти под n элементов и их инициализация
+  T* Allocate(size_t n)
+  {
+    if (n <= SmallSize)
+      return InlineMem();
+    return alloc_traits::allocate(alloc, n);
+  }
+  void Deallocate(T* p, size_t n) noexcept
+  {
+    if (p != InlineMem())
+      alloc_traits::deallocate(alloc, p, n);
+  }
+  T* CreateValues(size_t n)
+  {
+    T* p = Allocate(n);
+    try { uninitialized_value_construct_n(p, n); }
+    catch (...) { Deallocate(p, n); throw; }
+    return p;
+  }
+  T* CreateDefault(size_t n)
+  {
+    T* p = Allocate(n);
+    try { uninitialized_default_construct_n(p, n); }
+    catch (...) { Deallocate(p, n); throw; }
+    return p;
+  }
+  T* CreateCopy(const T* src, size_t n)
+  {
+    T* p = Allocate(n);
+    try { uninitialized_copy_n(src, n, p); }
+    catch (...) { Deallocate(p, n); throw; }
+    return p;
+  }
+  void Release() noexcept
+  {
+    if (pMem == nullptr)
+      return;
+    if (ext != nullptr)
+    {
+      (*ext)(pMem);
+      delete ext;
+      ext = nullptr;
+    }
+    else
+    {
+      destroy_n(pMem, sz);
+      Deallocate(pMem, sz);
+    }
+    pMem = nullptr;
+  }
+  // забирает содержимое v: буфер в куче передается, встроенный - перемещается
+  // поэлементно; v остается пустым
+  void Steal(TDynamicVector& v) noexcept
   {
-    if (sz == 0)
+    sz = v.sz;
+    if (v.IsInline())
+    {
+      pMem = InlineMem();
+      uninitialized_move_n(v.pMem, sz, pMem);
+      destroy_n(v.pMem, sz);
+    }
+    else
+      pMem = v.pMem;
+    ext = v.ext;
+    v.sz = 0;
+    v.pMem = nullptr;
+    v.ext = nullptr;
+  }
+  static size_t CheckedSize(size_t size)
+  {
+    if (size == 0)
       throw out_of_range("Vector size should be greater than zero");
-    pMem = new T[sz]();// {}; // У типа T д.б. конструктор по умолчанию
+    if (size > MAX_VECTOR_SIZE)
+      throw out_of_range("Vector size should not exceed MAX_VECTOR_SIZE");
+    return size;
+  }
+  // выражение "этот вектор Op n"
+  template<typename Op, typename N>
+  TVectorExpr<T, TExprBinary<Op, TExprLeaf<T>, N>> Combine(const N& n) const
+  {
+    return TVectorExpr<T, TExprBinary<Op, TExprLeaf<T>, N>>(TExprBinary<Op, TExprLeaf<T>, N>(TExprLeaf<T>(pMem), n), sz);
+  }
+public:
+  TDynamicVector(size_t size = 1, const Alloc& a = Alloc()) : sz(CheckedSize(size)), pMem(nullptr), alloc(a), ext(nullptr)
+  {
+    pMem = CreateValues(sz); // У типа T д.б. конструктор по умолчанию
+  }
+  TDynamicVector(size_t size, TNoInit, const Alloc& a = Alloc()) : sz(CheckedSize(size)), pMem(nullptr), alloc(a), ext(nullptr)
+  {
+    pMem = CreateDefault(sz);
   }
-  TDynamicVector(T* arr, size_t s) : sz(s)
+  TDynamicVector(T* arr, size_t s, const Alloc& a = Alloc()) : sz(s), pMem(nullptr), alloc(a), ext(nullptr)
   {
     assert(arr != nullptr && "TDynamicVector ctor requires non-nullptr arg");
-    pMem = new T[sz];
-    std::copy(arr, arr + sz, pMem);
+    pMem = CreateCopy(arr, sz);
+  }
+  template<typename D = default_delete<T[]>>
+  TDynamicVector(T* arr, size_t s, TAdopt, D deleter = D())
+    : sz(CheckedSize(s)), pMem(nullptr), alloc(), ext(nullptr)
+  {
+    assert(arr != nullptr && "TDynamicVector ctor requires non-nullptr arg");
+    ext = new TBufferDeleterImpl<T, D>(std::move(deleter));
+    pMem = arr;
   }
   TDynamicVector(const TDynamicVector& v)
+    : sz(v.sz), pMem(nullptr), alloc(alloc_traits::select_on_container_copy_construction(v.alloc)), ext(nullptr)
   {
+    pMem = CreateCopy(v.pMem, sz);
   }
-  TDynamicVector(TDynamicVector&& v) noexcept
+  TDynamicVector(TDynamicVector&& v) noexcept : sz(0), pMem(nullptr), alloc(v.alloc), ext(nullptr)
   {
+    Steal(v);
+  }
+  // вычисление выражения
+  template<typename E>
+  TDynamicVector(const TVectorExpr<T, E>& e, const Alloc& a = Alloc())
+    : sz(CheckedSize(e.size())), pMem(nullptr), alloc(a), ext(nullptr)
+  {
+    pMem = CreateDefault(sz);
+    try { e.EvalTo(pMem); }
+    catch (...) { Release(); throw; }
   }
   ~TDynamicVector()
   {
+    Release();
   }
   TDynamicVector& operator=(const TDynamicVector& v)
   {
+    if (this == &v)
+      return *this;
+    if (sz == v.sz)
+    {
+      std::copy(v.pMem, v.pMem + v.sz, pMem);
+      return *this;
+    }
+    if (v.sz <= SmallSize)
+    {
+      // встроенный буфер может быть занят текущими элементами: копия
+      // строится во временном векторе, при исключении *this не меняется
+      TDynamicVector tmp(v.pMem, v.sz, alloc);
+      return *this = std::move(tmp);
+    }
+    T* p = CreateCopy(v.pMem, v.sz);
+    Release();
+    pMem = p;
+    sz = v.sz;
+    return *this;
   }
   TDynamicVector& operator=(TDynamicVector&& v) noexcept
   {
-      return (*this); // заглушка
+    if (this == &v)
+      return *this;
+    Release();
+    alloc = v.alloc;
+    Steal(v);
+    return *this;
+  }
+  // при равных размерах выражение вычисляется на месте (в том числе
+  // a = a + b - элемент операнда читается до записи)
+  template<typename E>
+  TDynamicVector& operator=(const TVectorExpr<T, E>& e)
+  {
+    if (sz == e.size())
+      e.EvalTo(pMem);
+    else
+      *this = TDynamicVector(e, alloc);
+    return *this;
   }
 
   size_t size() const noexcept { return sz; }
+  T* data() noexcept { return pMem; }
+  const T* data() const noexcept { return pMem; }
+  Alloc get_allocator() const { return alloc; }
+
+  // отдает буфер вызывающему: {буфер, число элементов}, вектор становится
+  // пустым. Принятый через ADOPT буфер возвращается владельцу; собственный
+  // буфер нужно затем разрушить и освободить аллокатором get_allocator()
+  // с этим числом элементов: destroy_n(p, n), deallocate(p, n)
+  pair<T*, size_t> release()
+  {
+    if (IsInline())
+      throw logic_error("Inline vector storage cannot be released");
+    const pair<T*, size_t> res(pMem, sz);
+    delete ext;
+    ext = nullptr;
+    pMem = nullptr;
+    sz = 0;
+    return res;
+  }
+
+  // срез без копирования: len элементов с шагом stride начиная с offset
+  TVectorView<T> slice(size_t offset, size_t len, size_t stride = 1)
+  {
+    return TVectorView<T>(*this).slice(offset, len, stride);
+  }
+  TVectorView<const T> slice(size_t offset, size_t len, size_t stride = 1) const
+  {
+    return TVectorView<const T>(*this).slice(offset, len, stride);
+  }
 
   // индексация
   T& operator[](size_t ind)
   {
+    return pMem[ind];
   }
   const T& operator[](size_t ind) const
   {
+    return pMem[ind];
   }
   // индексация с контролем
   T& at(size_t ind)
   {
+    if (ind >= sz)
+      throw out_of_range("Vector index is out of range");
+    return pMem[ind];
   }
   const T& at(size_t ind) const
   {
+    if (ind >= sz)
+      throw out_of_range("Vector index is out of range");
+    return pMem[ind];
   }
 
   // сравнение
   bool operator==(const TDynamicVector& v) const noexcept
   {
+    if (sz != v.sz)
+      return false;
+    for (size_t i = 0; i < sz; i++)
+      if (!(pMem[i] == v.pMem[i]))
+        return false;
+    return true;
   }
   bool operator!=(const TDynamicVector& v) const noexcept
   {
+    return !(*this == v);
   }
 
-  // скалярные операции
-  TDynamicVector operator+(T val)
+  // скалярные операции (результат - выражение)
+  TVectorExpr<T, TExprBinary<TExprAdd, TExprLeaf<T>, TExprScalar<T>>> operator+(T val) const
   {
+    return Combine<TExprAdd>(TExprScalar<T>(val));
   }
-  TDynamicVector operator-(T val)
+  TVectorExpr<T, TExprBinary<TExprSub, TExprLeaf<T>, TExprScalar<T>>> operator-(T val) const
   {
+    return Combine<TExprSub>(TExprScalar<T>(val));
   }
-  TDynamicVector operator*(T val)
+  TVectorExpr<T, TExprBinary<TExprMul, TExprLeaf<T>, TExprScalar<T>>> operator*(T val) const
   {
+    return Combine<TExprMul>(TExprScalar<T>(val));
   }
 
-  // векторные операции
-  TDynamicVector operator+(const TDynamicVector& v)
+  // векторные операции (сумма и разность - выражения)
+  TVectorExpr<T, TExprBinary<TExprAdd, TExprLeaf<T>, TExprLeaf<T>>> operator+(const TDynamicVector& v) const
   {
+    if (sz != v.sz)
+      throw length_error("Vectors should have equal sizes");
+    return Combine<TExprAdd>(TExprLeaf<T>(v.pMem));
   }
-  TDynamicVector operator-(const TDynamicVector& v)
+  TVectorExpr<T, TExprBinary<TExprSub, TExprLeaf<T>, TExprLeaf<T>>> operator-(const TDynamicVector& v) const
   {
+    if (sz != v.sz)
+      throw length_error("Vectors should have equal sizes");
+    return Combine<TExprSub>(TExprLeaf<T>(v.pMem));
   }
-  T operator*(const TDynamicVector& v) noexcept(noexcept(T()))
+  template<typename E>
+  TVectorExpr<T, TExprBinary<TExprAdd, TExprLeaf<T>, E>> operator+(const TVectorExpr<T, E>& v) const
   {
+    if (sz != v.size())
+      throw length_error("Vectors should have equal sizes");
+    return Combine<TExprAdd>(v.node());
+  }
+  template<typename E>
+  TVectorExpr<T, TExprBinary<TExprSub, TExprLeaf<T>, E>> operator-(const TVectorExpr<T, E>& v) const
+  {
+    if (sz != v.size())
+      throw length_error("Vectors should have equal sizes");
+    return Combine<TExprSub>(v.node());
+  }
+  T operator*(const TDynamicVector& v) const
+  {
+    if (sz != v.sz)
+      throw length_error("Vectors should have equal sizes");
+    return simd_dot(pMem, v.pMem, sz);
+  }
+  template<typename E>
+  T operator*(const TVectorExpr<T, E>& v) const
+  {
+    return v * *this;
+  }
+
+  // операции с представлениями
+  TDynamicVector<T> operator+(TVectorView<const T> v) const
+  {
+    return TVectorView<const T>(*this) + v;
+  }
+  TDynamicVector<T> operator-(TVectorView<const T> v) const
+  {
+    return TVectorView<const T>(*this) - v;
+  }
+  T operator*(TVectorView<const T> v) const
+  {
+    return TVectorView<const T>(*this) * v;
   }
 
   friend void swap(TDynamicVector& lhs, TDynamicVector& rhs) noexcept
   {
+    if (lhs.IsInline() || rhs.IsInline())
+    {
+      TDynamicVector tmp(std::move(lhs));
+      lhs = std::move(rhs);
+      rhs = std::move(tmp);
+      return;
+    }
     std::swap(lhs.sz, rhs.sz);
     std::swap(lhs.pMem, rhs.pMem);
+    std::swap(lhs.alloc, rhs.alloc);
+    std::swap(lhs.ext, rhs.ext);
   }
 
   // ввод/вывод
@@ -120,56 +415,682 @@ public:
   }
 };
 
+// вектор - лист выражения
+template<typename T, typename Alloc, size_t SmallSize>
+TExprLeaf<T> ExprNode(const TDynamicVector<T, Alloc, SmallSize>& v) noexcept
+{
+  return TExprLeaf<T>(v.data());
+}
 
-// Динамическая матрица - 
-// шаблонная матрица на динамической памяти
+template<typename V, typename E>
+struct TIsVectorOf : false_type {};
+template<typename E, typename A, size_t N>
+struct TIsVectorOf<TDynamicVector<E, A, N>, E> : true_type {};
+
+// Представление вектора -
+// не владеющая ссылка на sz элементов чужого буфера, расположенных
+// с шагом stride (строка или столбец матрицы, срез вектора).
+// Результаты арифметических операций - новые TDynamicVector<T>
 template<typename T>
-class TDynamicMatrix : private TDynamicVector<TDynamicVector<T>>
+class TVectorView
 {
-  using TDynamicVector<TDynamicVector<T>>::pMem;
-  using TDynamicVector<TDynamicVector<T>>::sz;
+  using value_type = typename remove_const<T>::type;
+
+  T* pMem;
+  size_t sz;
+  size_t step;
 public:
-  TDynamicMatrix(size_t s = 1) : TDynamicVector<TDynamicVector<T>>(s)
+  TVectorView(T* p, size_t size, size_t stride = 1) : pMem(p), sz(size), step(stride)
+  {
+    assert(p != nullptr && "TVectorView ctor requires non-nullptr arg");
+  }
+  // из TDynamicVector (но не из классов, закрыто унаследованных от него);
+  // на константный или временный вектор - только представление const T
+  template<typename V, typename W = typename remove_reference<V>::type,
+    typename = typename enable_if<TIsVectorOf<typename remove_const<W>::type, value_type>::value &&
+      (is_const<T>::value || (is_lvalue_reference<V>::value && !is_const<W>::value))>::type>
+  TVectorView(V&& v) : pMem(v.data()), sz(v.size()), step(1) {}
+  template<typename U, typename = typename enable_if<is_const<T>::value && is_same<U, value_type>::value>::type>
+  TVectorView(const TVectorView<U>& v) : pMem(v.data()), sz(v.size()), step(v.stride()) {}
+
+  size_t size() const noexcept { return sz; }
+  size_t stride() const noexcept { return step; }
+  T* data() const noexcept { return pMem; }
+
+  TVectorView slice(size_t offset, size_t len, size_t stride = 1) const
+  {
+    if (len == 0 || stride == 0 || offset >= sz || (len - 1) > (sz - 1 - offset) / stride)
+      throw out_of_range("Slice is out of range");
+    return TVectorView(pMem + offset * step, len, stride * step);
+  }
+
+  // индексация
+  T& operator[](size_t ind) const
+  {
+    return pMem[ind * step];
+  }
+  // индексация с контролем
+  T& at(size_t ind) const
+  {
+    if (ind >= sz)
+      throw out_of_range("Vector index is out of range");
+    return pMem[ind * step];
+  }
+
+  // сравнение
+  bool operator==(TVectorView<const value_type> v) const noexcept
   {
+    if (sz != v.size())
+      return false;
     for (size_t i = 0; i < sz; i++)
-      pMem[i] = TDynamicVector<T>(sz);
+      if (!((*this)[i] == v[i]))
+        return false;
+    return true;
+  }
+  bool operator!=(TVectorView<const value_type> v) const noexcept
+  {
+    return !(*this == v);
   }
 
-  using TDynamicVector<TDynamicVector<T>>::operator[];
+  // скалярные операции
+  TDynamicVector<value_type> operator+(value_type val) const
+  {
+    TDynamicVector<value_type> res(sz, NO_INIT);
+    for (size_t i = 0; i < sz; i++)
+      res[i] = (*this)[i] + val;
+    return res;
+  }
+  TDynamicVector<value_type> operator-(value_type val) const
+  {
+    TDynamicVector<value_type> res(sz, NO_INIT);
+    for (size_t i = 0; i < sz; i++)
+      res[i] = (*this)[i] - val;
+    return res;
+  }
+  TDynamicVector<value_type> operator*(value_type val) const
+  {
+    TDynamicVector<value_type> res(sz, NO_INIT);
+    for (size_t i = 0; i < sz; i++)
+      res[i] = (*this)[i] * val;
+    return res;
+  }
+
+  // векторные операции
+  TDynamicVector<value_type> operator+(TVectorView<const value_type> v) const
+  {
+    if (sz != v.size())
+      throw length_error("Vectors should have equal sizes");
+    TDynamicVector<value_type> res(sz, NO_INIT);
+    for (size_t i = 0; i < sz; i++)
+      res[i] = (*this)[i] + v[i];
+    return res;
+  }
+  TDynamicVector<value_type> operator-(TVectorView<const value_type> v) const
+  {
+    if (sz != v.size())
+      throw length_error("Vectors should have equal sizes");
+    TDynamicVector<value_type> res(sz, NO_INIT);
+    for (size_t i = 0; i < sz; i++)
+      res[i] = (*this)[i] - v[i];
+    return res;
+  }
+  value_type operator*(TVectorView<const value_type> v) const
+  {
+    if (sz != v.size())
+      throw length_error("Vectors should have equal sizes");
+    value_type res = value_type();
+    for (size_t i = 0; i < sz; i++)
+      res += (*this)[i] * v[i];
+    return res;
+  }
+
+  // операции с выражениями: выражение вычисляется во временный вектор
+  template<typename E>
+  TDynamicVector<value_type> operator+(const TVectorExpr<value_type, E>& v) const
+  {
+    return *this + TVectorView<const value_type>(TDynamicVector<value_type>(v));
+  }
+  template<typename E>
+  TDynamicVector<value_type> operator-(const TVectorExpr<value_type, E>& v) const
+  {
+    return *this - TVectorView<const value_type>(TDynamicVector<value_type>(v));
+  }
+
+  friend ostream& operator<<(ostream& ostr, const TVectorView& v)
+  {
+    for (size_t i = 0; i < v.sz; i++)
+      ostr << v[i] << ' '; // требуется оператор<< для типа T
+    return ostr;
+  }
+};
+
+
+// Порядок хранения элементов матрицы
+struct TRowMajor {}; // построчно
+struct TColMajor {}; // по столбцам
+
+// Динамическая матрица - 
+// шаблонная прямоугольная матрица на динамической памяти.
+// Элементы хранятся в одном непрерывном буфере (унаследованном
+// от TDynamicVector<T>) построчно - строка i начинается с pMem + i * ncols -
+// или, при Layout = TColMajor, по столбцам - столбец j начинается
+// с pMem + j * nrows. Ядра выбирают порядок циклов по Layout так, чтобы
+// внутренний цикл шел по буферу подряд.
+// Встроенный буфер вектора не используется - буфер матрицы всегда в куче
+// и выровнен аллокатором
+template<typename T, typename Alloc = TAlignedAllocator<T>, typename Layout = TRowMajor>
+class TDynamicMatrix : private TDynamicVector<T, Alloc, 0>
+{
+  static_assert(is_same<Layout, TRowMajor>::value || is_same<Layout, TColMajor>::value,
+    "Layout should be TRowMajor or TColMajor");
+  static constexpr bool byRows = is_same<Layout, TRowMajor>::value;
+
+  using TDynamicVector<T, Alloc, 0>::pMem;
+
+  size_t nrows, ncols;
+
+  static size_t CheckedSize(size_t r, size_t c)
+  {
+    if (r == 0 || c == 0)
+      throw out_of_range("Matrix size should be greater than zero");
+    if (c > MAX_MATRIX_ELEMENTS / r)
+      throw out_of_range("Matrix size should not exceed MAX_MATRIX_ELEMENTS");
+    return r * c;
+  }
+
+  // выражение "эта матрица Op n"
+  template<typename Op, typename N>
+  TMatrixExpr<T, TExprBinary<Op, TExprLeaf<T>, N>, Layout> Combine(const N& n) const
+  {
+    return TMatrixExpr<T, TExprBinary<Op, TExprLeaf<T>, N>, Layout>(
+      TExprBinary<Op, TExprLeaf<T>, N>(TExprLeaf<T>(pMem), n), nrows, ncols);
+  }
+
+  // позиция элемента (i, j) в буфере
+  size_t Offset(size_t i, size_t j) const noexcept { return byRows ? i * ncols + j : j * nrows + i; }
+
+  // res = A * x; по столбцам хранится A^T построчно, поэтому res = x^T A^T
+  void MultiplyVector(const T* x, T* res) const
+  {
+    if constexpr (byRows)
+      gemv(nrows, ncols, pMem, ncols, x, res);
+    else
+      gemv_t(ncols, nrows, pMem, nrows, x, res);
+  }
+  // res = x^T * A без построения A^T
+  void MultiplyVectorLeft(const T* x, T* res) const
+  {
+    if constexpr (byRows)
+      gemv_t(nrows, ncols, pMem, ncols, x, res);
+    else
+      gemv(ncols, nrows, pMem, nrows, x, res);
+  }
+public:
+  TDynamicMatrix(size_t s = 1) : TDynamicMatrix(s, s)
+  {
+  }
+  TDynamicMatrix(size_t r, size_t c) : TDynamicVector<T, Alloc, 0>(CheckedSize(r, c)), nrows(r), ncols(c)
+  {
+  }
+  TDynamicMatrix(size_t r, size_t c, TNoInit)
+    : TDynamicVector<T, Alloc, 0>(CheckedSize(r, c), NO_INIT), nrows(r), ncols(c)
+  {
+  }
+  TDynamicMatrix(const TDynamicMatrix& m) = default;
+  // перемещенная матрица пуста: 0 x 0
+  TDynamicMatrix(TDynamicMatrix&& m) noexcept
+    : TDynamicVector<T, Alloc, 0>(std::move(m)), nrows(m.nrows), ncols(m.ncols)
+  {
+    m.nrows = m.ncols = 0;
+  }
+  TDynamicMatrix& operator=(const TDynamicMatrix& m) = default;
+  TDynamicMatrix& operator=(TDynamicMatrix&& m) noexcept
+  {
+    if (this == &m)
+      return *this;
+    TDynamicVector<T, Alloc, 0>::operator=(std::move(m));
+    nrows = m.nrows;
+    ncols = m.ncols;
+    m.nrows = m.ncols = 0;
+    return *this;
+  }
+  // из матрицы с другим порядком хранения
+  template<typename L, typename = typename enable_if<!is_same<L, Layout>::value>::type>
+  explicit TDynamicMatrix(const TDynamicMatrix<T, Alloc, L>& m)
+    : TDynamicVector<T, Alloc, 0>(CheckedSize(m.rows(), m.cols()), NO_INIT), nrows(m.rows()), ncols(m.cols())
+  {
+    const T* src = m.data();
+    for (size_t i = 0; i < nrows; i++)
+      for (size_t j = 0; j < ncols; j++)
+        pMem[Offset(i, j)] = src[byRows ? j * nrows + i : i * ncols + j];
+  }
+  // принимает во владение буфер r x c в порядке Layout без копирования (см. TAdopt)
+  template<typename D = default_delete<T[]>>
+  TDynamicMatrix(T* arr, size_t r, size_t c, TAdopt, D deleter = D())
+    : TDynamicVector<T, Alloc, 0>(arr, CheckedSize(r, c), ADOPT, std::move(deleter)), nrows(r), ncols(c)
+  {
+  }
+  // вычисление выражения
+  template<typename E>
+  TDynamicMatrix(const TMatrixExpr<T, E, Layout>& e)
+    : TDynamicVector<T, Alloc, 0>(CheckedSize(e.rows(), e.cols()), NO_INIT), nrows(e.rows()), ncols(e.cols())
+  {
+    e.EvalTo(pMem);
+  }
+  // при равных размерах выражение вычисляется на месте
+  template<typename E>
+  TDynamicMatrix& operator=(const TMatrixExpr<T, E, Layout>& e)
+  {
+    if (nrows == e.rows() && ncols == e.cols())
+      e.EvalTo(pMem);
+    else
+      *this = TDynamicMatrix(e);
+    return *this;
+  }
+
+  // size() - число строк (для квадратной матрицы - ее порядок)
+  size_t size() const noexcept { return nrows; }
+  size_t rows() const noexcept { return nrows; }
+  size_t cols() const noexcept { return ncols; }
+  T* data() noexcept { return pMem; }
+  const T* data() const noexcept { return pMem; }
+  using TDynamicVector<T, Alloc, 0>::get_allocator;
+
+  // отдает буфер вызывающему: {буфер, rows() * cols()} (см.
+  // TDynamicVector::release), матрица становится пустой
+  pair<T*, size_t> release()
+  {
+    nrows = ncols = 0;
+    return TDynamicVector<T, Alloc, 0>::release();
+  }
+
+  // представления без копирования: строка, столбец,
+  // подматрица (только для построчного хранения)
+  TVectorView<T> row(size_t i)
+  {
+    if (i >= nrows)
+      throw out_of_range("Matrix index is out of range");
+    return TVectorView<T>(pMem + Offset(i, 0), ncols, byRows ? 1 : nrows);
+  }
+  TVectorView<const T> row(size_t i) const
+  {
+    if (i >= nrows)
+      throw out_of_range("Matrix index is out of range");
+    return TVectorView<const T>(pMem + Offset(i, 0), ncols, byRows ? 1 : nrows);
+  }
+  TVectorView<T> col(size_t j)
+  {
+    if (j >= ncols)
+      throw out_of_range("Matrix index is out of range");
+    return TVectorView<T>(pMem + Offset(0, j), nrows, byRows ? ncols : 1);
+  }
+  TVectorView<const T> col(size_t j) const
+  {
+    if (j >= ncols)
+      throw out_of_range("Matrix index is out of range");
+    return TVectorView<const T>(pMem + Offset(0, j), nrows, byRows ? ncols : 1);
+  }
+  TMatrixView<T> block(size_t i, size_t j, size_t r, size_t c)
+  {
+    static_assert(byRows, "Matrix views require row-major layout");
+    return TMatrixView<T>(*this).block(i, j, r, c);
+  }
+  TMatrixView<const T> block(size_t i, size_t j, size_t r, size_t c) const
+  {
+    static_assert(byRows, "Matrix views require row-major layout");
+    return TMatrixView<const T>(*this).block(i, j, r, c);
+  }
+
+  // индексация: m[i][j] без контроля. Строка построчной матрицы -
+  // указатель в общий буфер, матрицы по столбцам - представление с шагом nrows
+  auto operator[](size_t ind)
+  {
+    if constexpr (byRows)
+      return pMem + ind * ncols;
+    else
+      return TVectorView<T>(pMem + ind, ncols, nrows);
+  }
+  auto operator[](size_t ind) const
+  {
+    if constexpr (byRows)
+      return static_cast<const T*>(pMem + ind * ncols);
+    else
+      return TVectorView<const T>(pMem + ind, ncols, nrows);
+  }
+  // индексация с контролем
+  T& at(size_t i, size_t j)
+  {
+    if (i >= nrows || j >= ncols)
+      throw out_of_range("Matrix index is out of range");
+    return pMem[Offset(i, j)];
+  }
+  const T& at(size_t i, size_t j) const
+  {
+    if (i >= nrows || j >= ncols)
+      throw out_of_range("Matrix index is out of range");
+    return pMem[Offset(i, j)];
+  }
 
   // сравнение
   bool operator==(const TDynamicMatrix& m) const noexcept
   {
+    return nrows == m.nrows && ncols == m.ncols && TDynamicVector<T, Alloc, 0>::operator==(m);
+  }
+  bool operator!=(const TDynamicMatrix& m) const noexcept
+  {
+    return !(*this == m);
   }
 
   // матрично-скалярные операции
-  TDynamicMatrix operator*(const T& val)
+  TMatrixExpr<T, TExprBinary<TExprMul, TExprLeaf<T>, TExprScalar<T>>, Layout> operator*(const T& val) const
   {
+    return Combine<TExprMul>(TExprScalar<T>(val));
   }
 
   // матрично-векторные операции
-  TDynamicVector<T> operator*(const TDynamicVector<T>& v)
+  TDynamicVector<T, Alloc> operator*(const TDynamicVector<T, Alloc>& v) const
+  {
+    if (ncols != v.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    TDynamicVector<T, Alloc> res(nrows, NO_INIT);
+    MultiplyVector(v.data(), res.data());
+    return res;
+  }
+  // x^T * A = (A^T x)^T
+  friend TDynamicVector<T, Alloc> operator*(const TDynamicVector<T, Alloc>& v, const TDynamicMatrix& m)
   {
+    if (m.nrows != v.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    TDynamicVector<T, Alloc> res(m.ncols, NO_INIT);
+    m.MultiplyVectorLeft(v.data(), res.data());
+    return res;
   }
 
-  // матрично-матричные операции
-  TDynamicMatrix operator+(const TDynamicMatrix& m)
+  // матрично-матричные операции (сумма и разность - выражения)
+  TMatrixExpr<T, TExprBinary<TExprAdd, TExprLeaf<T>, TExprLeaf<T>>, Layout> operator+(const TDynamicMatrix& m) const
+  {
+    if (nrows != m.nrows || ncols != m.ncols)
+      throw length_error("Matrices should have equal sizes");
+    return Combine<TExprAdd>(TExprLeaf<T>(m.pMem));
+  }
+  TMatrixExpr<T, TExprBinary<TExprSub, TExprLeaf<T>, TExprLeaf<T>>, Layout> operator-(const TDynamicMatrix& m) const
   {
+    if (nrows != m.nrows || ncols != m.ncols)
+      throw length_error("Matrices should have equal sizes");
+    return Combine<TExprSub>(TExprLeaf<T>(m.pMem));
   }
-  TDynamicMatrix operator-(const TDynamicMatrix& m)
+  template<typename E>
+  TMatrixExpr<T, TExprBinary<TExprAdd, TExprLeaf<T>, E>, Layout> operator+(const TMatrixExpr<T, E, Layout>& m) const
   {
+    if (nrows != m.rows() || ncols != m.cols())
+      throw length_error("Matrices should have equal sizes");
+    return Combine<TExprAdd>(m.node());
   }
-  TDynamicMatrix operator*(const TDynamicMatrix& m)
+  template<typename E>
+  TMatrixExpr<T, TExprBinary<TExprSub, TExprLeaf<T>, E>, Layout> operator-(const TMatrixExpr<T, E, Layout>& m) const
   {
+    if (nrows != m.rows() || ncols != m.cols())
+      throw length_error("Matrices should have equal sizes");
+    return Combine<TExprSub>(m.node());
+  }
+  // (r x n) * (n x c) = (r x c); большие - по Штрассену - Винограду
+  TDynamicMatrix operator*(const TDynamicMatrix& m) const
+  {
+    if (ncols != m.nrows)
+      throw length_error("Matrix sizes should be compatible");
+    TDynamicMatrix res(nrows, m.ncols, NO_INIT);
+    if constexpr (byRows)
+      strassen(nrows, m.ncols, ncols, pMem, ncols, m.pMem, m.ncols, res.pMem, m.ncols);
+    else
+      // по столбцам хранятся транспонированные по строкам: res^T = m^T * this^T
+      strassen(m.ncols, nrows, ncols, m.pMem, m.nrows, pMem, nrows, res.pMem, nrows);
+    return res;
   }
 
-  // ввод/вывод
+  // операции с представлениями (с матричными - только для построчного хранения)
+  TDynamicVector<T> operator*(TVectorView<const T> v) const
+  {
+    if (ncols != v.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    TDynamicVector<T> res(nrows, NO_INIT);
+    if (v.stride() == 1)
+      MultiplyVector(v.data(), res.data());
+    else
+    {
+      // ядру нужен непрерывный x: элементы с шагом собираются подряд
+      TDynamicVector<T> x(ncols, NO_INIT);
+      for (size_t j = 0; j < ncols; j++)
+        x[j] = v[j];
+      MultiplyVector(x.data(), res.data());
+    }
+    return res;
+  }
+  TDynamicMatrix<T> operator+(TMatrixView<const T> m) const
+  {
+    static_assert(byRows, "Matrix views require row-major layout");
+    return TMatrixView<const T>(*this) + m;
+  }
+  TDynamicMatrix<T> operator-(TMatrixView<const T> m) const
+  {
+    static_assert(byRows, "Matrix views require row-major layout");
+    return TMatrixView<const T>(*this) - m;
+  }
+  TDynamicMatrix<T> operator*(TMatrixView<const T> m) const
+  {
+    static_assert(byRows, "Matrix views require row-major layout");
+    return TMatrixView<const T>(*this) * m;
+  }
+
+  // ввод/вывод (по строкам при любом порядке хранения)
   friend istream& operator>>(istream& istr, TDynamicMatrix& v)
   {
+    for (size_t i = 0; i < v.nrows; i++)
+      for (size_t j = 0; j < v.ncols; j++)
+        istr >> v.pMem[v.Offset(i, j)]; // требуется оператор>> для типа T
+    return istr;
   }
   friend ostream& operator<<(ostream& ostr, const TDynamicMatrix& v)
   {
+    for (size_t i = 0; i < v.nrows; i++)
+    {
+      for (size_t j = 0; j < v.ncols; j++)
+        ostr << v.pMem[v.Offset(i, j)] << ' '; // требуется оператор<< для типа T
+      ostr << endl;
+    }
+    return ostr;
   }
 };
 
+// матрица - лист выражения с ее порядком хранения
+template<typename T, typename Alloc, typename Layout>
+TExprLeaf<T> ExprMatrixNode(const TDynamicMatrix<T, Alloc, Layout>& m, Layout) noexcept
+{
+  return TExprLeaf<T>(m.data());
+}
+
+// Представление матрицы -
+// не владеющая ссылка на прямоугольный блок rows x cols построчно
+// хранимой матрицы; соседние строки блока отстоят на ld элементов.
+// Результаты арифметических операций - новые TDynamicMatrix<T>
+template<typename T>
+class TMatrixView
+{
+  using value_type = typename remove_const<T>::type;
+
+  T* pMem;
+  size_t nrows, ncols, ld;
+public:
+  TMatrixView(T* p, size_t r, size_t c, size_t lead) : pMem(p), nrows(r), ncols(c), ld(lead)
+  {
+    assert(p != nullptr && "TMatrixView ctor requires non-nullptr arg");
+  }
+  template<typename A>
+  TMatrixView(TDynamicMatrix<value_type, A>& m)
+    : pMem(m.data()), nrows(m.rows()), ncols(m.cols()), ld(m.cols()) {}
+  template<typename A, typename U = T, typename = typename enable_if<is_const<U>::value>::type>
+  TMatrixView(const TDynamicMatrix<value_type, A>& m)
+    : pMem(m.data()), nrows(m.rows()), ncols(m.cols()), ld(m.cols()) {}
+  template<typename U, typename = typename enable_if<is_const<T>::value && is_same<U, value_type>::value>::type>
+  TMatrixView(const TMatrixView<U>& m)
+    : pMem(m.data()), nrows(m.rows()), ncols(m.cols()), ld(m.lead()) {}
+
+  size_t rows() const noexcept { return nrows; }
+  size_t cols() const noexcept { return ncols; }
+  size_t lead() const noexcept { return ld; }
+  T* data() const noexcept { return pMem; }
+
+  TVectorView<T> row(size_t i) const
+  {
+    if (i >= nrows)
+      throw out_of_range("Matrix index is out of range");
+    return TVectorView<T>(pMem + i * ld, ncols);
+  }
+  TVectorView<T> col(size_t j) const
+  {
+    if (j >= ncols)
+      throw out_of_range("Matrix index is out of range");
+    return TVectorView<T>(pMem + j, nrows, ld);
+  }
+  TMatrixView block(size_t i, size_t j, size_t r, size_t c) const
+  {
+    if (r == 0 || c == 0 || i >= nrows || j >= ncols || r > nrows - i || c > ncols - j)
+      throw out_of_range("Block is out of range");
+    return TMatrixView(pMem + i * ld + j, r, c, ld);
+  }
+
+  // индексация: строка блока, m[i][j] без контроля
+  T* operator[](size_t ind) const
+  {
+    return pMem + ind * ld;
+  }
+  // индексация с контролем
+  T& at(size_t i, size_t j) const
+  {
+    if (i >= nrows || j >= ncols)
+      throw out_of_range("Matrix index is out of range");
+    return pMem[i * ld + j];
+  }
+
+  // сравнение
+  bool operator==(TMatrixView<const value_type> m) const noexcept
+  {
+    if (nrows != m.rows() || ncols != m.cols())
+      return false;
+    for (size_t i = 0; i < nrows; i++)
+      for (size_t j = 0; j < ncols; j++)
+        if (!((*this)[i][j] == m[i][j]))
+          return false;
+    return true;
+  }
+  bool operator!=(TMatrixView<const value_type> m) const noexcept
+  {
+    return !(*this == m);
+  }
+
+  // матрично-скалярные операции
+  TDynamicMatrix<value_type> operator*(const value_type& val) const
+  {
+    TDynamicMatrix<value_type> res(nrows, ncols, NO_INIT);
+    for (size_t i = 0; i < nrows; i++)
+      for (size_t j = 0; j < ncols; j++)
+        res[i][j] = (*this)[i][j] * val;
+    return res;
+  }
+
+  // матрично-векторные операции
+  TDynamicVector<value_type> operator*(TVectorView<const value_type> v) const
+  {
+    if (ncols != v.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    TDynamicVector<value_type> res(nrows, NO_INIT);
+    for (size_t i = 0; i < nrows; i++)
+    {
+      const T* row = (*this)[i];
+      value_type sum = value_type();
+      for (size_t j = 0; j < ncols; j++)
+        sum += row[j] * v[j];
+      res[i] = sum;
+    }
+    return res;
+  }
+
+  // матрично-матричные операции
+  TDynamicMatrix<value_type> operator+(TMatrixView<const value_type> m) const
+  {
+    if (nrows != m.rows() || ncols != m.cols())
+      throw length_error("Matrices should have equal sizes");
+    TDynamicMatrix<value_type> res(nrows, ncols, NO_INIT);
+    for (size_t i = 0; i < nrows; i++)
+      for (size_t j = 0; j < ncols; j++)
+        res[i][j] = (*this)[i][j] + m[i][j];
+    return res;
+  }
+  TDynamicMatrix<value_type> operator-(TMatrixView<const value_type> m) const
+  {
+    if (nrows != m.rows() || ncols != m.cols())
+      throw length_error("Matrices should have equal sizes");
+    TDynamicMatrix<value_type> res(nrows, ncols, NO_INIT);
+    for (size_t i = 0; i < nrows; i++)
+      for (size_t j = 0; j < ncols; j++)
+        res[i][j] = (*this)[i][j] - m[i][j];
+    return res;
+  }
+  TDynamicMatrix<value_type> operator*(TMatrixView<const value_type> m) const
+  {
+    if (ncols != m.rows())
+      throw length_error("Matrix sizes should be compatible");
+    TDynamicMatrix<value_type> res(nrows, m.cols());
+    gemm<value_type>(nrows, m.cols(), ncols, pMem, ld, m.data(), m.lead(), res.data(), m.cols());
+    return res;
+  }
+
+  // операции с выражениями: выражение вычисляется во временную матрицу
+  template<typename E>
+  TDynamicMatrix<value_type> operator+(const TMatrixExpr<value_type, E, TRowMajor>& m) const
+  {
+    return *this + TMatrixView<const value_type>(TDynamicMatrix<value_type>(m));
+  }
+  template<typename E>
+  TDynamicMatrix<value_type> operator-(const TMatrixExpr<value_type, E, TRowMajor>& m) const
+  {
+    return *this - TMatrixView<const value_type>(TDynamicMatrix<value_type>(m));
+  }
+
+  friend ostream& operator<<(ostream& ostr, const TMatrixView& m)
+  {
+    for (size_t i = 0; i < m.nrows; i++)
+    {
+      for (size_t j = 0; j < m.ncols; j++)
+        ostr << m[i][j] << ' '; // требуется оператор<< для типа T
+      ostr << endl;
+    }
+    return ostr;
+  }
+};
+
+// Произведения с выражениями: выражение-операнд вычисляется во временный
+// вектор (матрицу). Справа - для любого M с произведением на представление
+// (матрицы и представления, в том числе из других заголовков)
+template<typename M, typename T, typename E, typename = typename enable_if<!TIsExpr<M>::value>::type>
+auto operator*(const M& m, const TVectorExpr<T, E>& v) -> decltype(m * declval<TVectorView<const T>>())
+{
+  return m * TVectorView<const T>(TDynamicVector<T>(v));
+}
+template<typename M, typename T, typename E, typename = typename enable_if<!TIsExpr<M>::value>::type>
+auto operator*(const M& m, const TMatrixExpr<T, E, TRowMajor>& e) -> decltype(m * declval<TMatrixView<const T>>())
+{
+  return m * TMatrixView<const T>(TDynamicMatrix<T>(e));
+}
+// слева - на все, кроме скаляра (выражение * скаляр - выражение)
+template<typename T, typename E, typename Layout, typename U,
+  typename = typename enable_if<!is_convertible<U, T>::value>::type>
+auto operator*(const TMatrixExpr<T, E, Layout>& e, const U& x)
+  -> decltype(declval<const TDynamicMatrix<T, TAlignedAllocator<T>, Layout>&>() * x)
+{
+  return TDynamicMatrix<T, TAlignedAllocator<T>, Layout>(e) * x;
+}
+
+// специализация TDynamicMatrix<bool>
+#include "tbitmatrix.h"
+
 #endif
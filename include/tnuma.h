@@ -0,0 +1,120 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TNuma_H__
+#define __TNuma_H__
+
+#include <thread>
+#include <vector>
+#include "tmatrix.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Размещение больших матриц на узлах NUMA.
+// Страница попадает на узел потока, первым записавшего в нее (first touch).
+// Конструктор матрицы обнуляет весь буфер в одном потоке, поэтому для
+// размещения по узлам матрица создается с NO_INIT, а затем:
+// - first_touch() - строки заполняются теми же потоками (то же разбиение
+//   parallel_rows), что будут их обрабатывать;
+// - interleave_pages() - страницы распределяются по узлам поочередно.
+// Узлы страниц после размещения сообщает page_nodes()
+
+// строки [first, last) части part из parts при равномерном разбиении rows строк
+inline pair<size_t, size_t> row_range(size_t rows, size_t part, size_t parts)
+{
+  const size_t base = rows / parts, extra = rows % parts;
+  const size_t first = part * base + min(part, extra);
+  return { first, first + base + (part < extra ? 1 : 0) };
+}
+
+// f(first, last) для каждой части строк в своем потоке; threads == 0 -
+// по числу аппаратных потоков
+template<typename F>
+void parallel_rows(size_t rows, size_t threads, F f)
+{
+  if (rows == 0)
+    return;
+  if (threads == 0)
+    threads = max<size_t>(1, thread::hardware_concurrency());
+  threads = min(threads, rows);
+  vector<thread> workers;
+  workers.reserve(threads);
+  for (size_t t = 1; t < threads; t++)
+  {
+    const pair<size_t, size_t> r = row_range(rows, t, threads);
+    workers.emplace_back(f, r.first, r.second);
+  }
+  const pair<size_t, size_t> r = row_range(rows, 0, threads);
+  f(r.first, r.second);
+  for (thread& w : workers)
+    w.join();
+}
+
+// первое касание строк матрицы потоками parallel_rows(rows, threads):
+// элементы получают значение T()
+template<typename T, typename Alloc>
+void first_touch(TDynamicMatrix<T, Alloc>& m, size_t threads = 0)
+{
+  const size_t cols = m.cols();
+  parallel_rows(m.rows(), threads, [&m, cols](size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; i++)
+    {
+      T* row = m[i];
+      for (size_t j = 0; j < cols; j++)
+        row[j] = T();
+    }
+  });
+}
+
+// чередование страниц [p, p + bytes) по всем доступным узлам.
+// Действует на страницы, которых еще не касались; границы расширяются
+// до целых страниц, поэтому буфер лучше выделять отдельным отображением
+// (THugePageAllocator). false - политика не установлена (нет NUMA, запрет)
+inline bool interleave_pages(const void* p, size_t bytes)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+  const int MPOL_INTERLEAVE_MODE = 3;
+  const uintptr_t page = uintptr_t(sysconf(_SC_PAGESIZE));
+  const uintptr_t first = reinterpret_cast<uintptr_t>(p) & ~(page - 1);
+  const uintptr_t last = (reinterpret_cast<uintptr_t>(p) + bytes + page - 1) & ~(page - 1);
+  unsigned long nodes[4] = { ~0ul, ~0ul, ~0ul, ~0ul }; // все узлы, ядро оставит доступные
+  return syscall(SYS_mbind, first, last - first, MPOL_INTERLEAVE_MODE, nodes,
+    sizeof(nodes) * 8, 0) == 0;
+#else
+  (void)p; (void)bytes;
+  return false;
+#endif
+}
+
+// узлы NUMA страниц [p, p + bytes), по элементу на страницу.
+// Отрицательное значение - страница еще не размещена или узел неизвестен;
+// вне Linux - пустой вектор
+inline vector<int> page_nodes(const void* p, size_t bytes)
+{
+#if defined(__linux__) && defined(SYS_move_pages)
+  const uintptr_t page = uintptr_t(sysconf(_SC_PAGESIZE));
+  const uintptr_t first = reinterpret_cast<uintptr_t>(p) & ~(page - 1);
+  const uintptr_t last = (reinterpret_cast<uintptr_t>(p) + bytes + page - 1) & ~(page - 1);
+  vector<void*> pages((last - first) / page);
+  vector<int> status(pages.size(), -1);
+  for (size_t k = 0; k < pages.size(); k++)
+    pages[k] = reinterpret_cast<void*>(first + k * page);
+  // move_pages без целевых узлов только сообщает текущие узлы
+  if (!pages.empty() && syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0)
+    status.assign(pages.size(), -errno);
+  return status;
+#else
+  (void)p; (void)bytes;
+  return vector<int>();
+#endif
+}
+
+#endif
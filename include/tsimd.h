@@ -0,0 +1,417 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TSimd_H__
+#define __TSimd_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Векторные ядра поэлементных операций и скалярного произведения
+// для float, double, int32_t и int64_t с выбором набора инструкций
+// (SSE2, AVX2 с FMA, AVX-512) при первом обращении по CPUID. Ядра собираются
+// в одном двоичном файле атрибутами target, поэтому флаги -mavx2 и т.п.
+// не нужны. Для остальных типов и платформ - обычные циклы
+#if defined(__x86_64__) || defined(_M_X64)
+#define MP2_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MP2_TARGET(isa) __attribute__((target(isa)))
+#define MP2_SIMD_ENTRY(isa) __attribute__((target(isa), flatten))
+#else
+#define MP2_TARGET(isa)
+#define MP2_SIMD_ENTRY(isa)
+#endif
+
+// Ядро над регистрами V собирается под набор V::isa: иначе без
+// оптимизации (flatten не встраивает) векторы передаются между
+// функциями с разными наборами по несовместимому ABI. Clang не
+// принимает зависимый аргумент target, там ядро встраивается во вход
+#if defined(__clang__)
+#define MP2_KERNEL(V) __attribute__((always_inline))
+#elif defined(__GNUC__) && defined(MP2_SIMD_X86)
+#define MP2_KERNEL(V) __attribute__((target(V::isa)))
+#else
+#define MP2_KERNEL(V)
+#endif
+
+enum TSimdLevel { SIMD_NONE, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 };
+
+// наилучший набор инструкций процессора и ОС (AVX2 - вместе с FMA,
+// AVX-512 - F и DQ)
+inline TSimdLevel simd_detect()
+{
+#ifdef MP2_SIMD_X86
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  const int maxId = info[0];
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0, fma = (info[2] & (1 << 12)) != 0;
+  const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+  bool avx2 = false, avx512 = false;
+  if (maxId >= 7)
+  {
+    __cpuidex(info, 7, 0);
+    avx2 = (info[1] & (1 << 5)) != 0 && fma && (xcr0 & 0x6) == 0x6;
+    avx512 = (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 17)) != 0 && (xcr0 & 0xe6) == 0xe6;
+  }
+#else
+  __builtin_cpu_init();
+  const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  const bool avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+#endif
+  return avx512 ? SIMD_AVX512 : avx2 ? SIMD_AVX2 : SIMD_SSE2;
+#else
+  return SIMD_NONE;
+#endif
+}
+
+inline TSimdLevel& ActiveSimdLevel()
+{
+  static TSimdLevel level = simd_detect();
+  return level;
+}
+
+// используемый набор инструкций
+inline TSimdLevel simd_level() { return ActiveSimdLevel(); }
+// ограничение набора (не выше доступного); вызывать до запуска потоков
+inline void set_simd_level(TSimdLevel level)
+{
+  const TSimdLevel best = simd_detect();
+  ActiveSimdLevel() = level < best ? level : best;
+}
+
+#ifdef MP2_SIMD_X86
+
+// Операции над регистрами уровня L для типа T: load, store, add, sub,
+// set1, zero и - где есть команда умножения - mul и fma(a, b, c) = a * b + c
+// (hasMul). fma - одна команда с одним округлением для float и double
+// на AVX2 и AVX-512, иначе - mul и add
+template<typename T> struct TSse2;
+template<typename T> struct TAvx2;
+template<typename T> struct TAvx512;
+
+template<> struct TSse2<float>
+{
+  using reg = __m128;
+  static const size_t width = 4;
+  static const bool hasMul = true;
+  static constexpr const char isa[] = "sse2";
+  MP2_TARGET("sse2") static reg load(const float* p) { return _mm_loadu_ps(p); }
+  MP2_TARGET("sse2") static void store(float* p, reg a) { _mm_storeu_ps(p, a); }
+  MP2_TARGET("sse2") static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+  MP2_TARGET("sse2") static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+  MP2_TARGET("sse2") static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+  MP2_TARGET("sse2") static reg fma(reg a, reg b, reg c) { return add(mul(a, b), c); }
+  MP2_TARGET("sse2") static reg set1(float a) { return _mm_set1_ps(a); }
+  MP2_TARGET("sse2") static reg zero() { return _mm_setzero_ps(); }
+};
+template<> struct TSse2<double>
+{
+  using reg = __m128d;
+  static const size_t width = 2;
+  static const bool hasMul = true;
+  static constexpr const char isa[] = "sse2";
+  MP2_TARGET("sse2") static reg load(const double* p) { return _mm_loadu_pd(p); }
+  MP2_TARGET("sse2") static void store(double* p, reg a) { _mm_storeu_pd(p, a); }
+  MP2_TARGET("sse2") static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+  MP2_TARGET("sse2") static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+  MP2_TARGET("sse2") static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+  MP2_TARGET("sse2") static reg fma(reg a, reg b, reg c) { return add(mul(a, b), c); }
+  MP2_TARGET("sse2") static reg set1(double a) { return _mm_set1_pd(a); }
+  MP2_TARGET("sse2") static reg zero() { return _mm_setzero_pd(); }
+};
+template<> struct TSse2<int32_t>
+{
+  using reg = __m128i;
+  static const size_t width = 4;
+  static const bool hasMul = false; // mullo_epi32 - только с SSE4.1
+  static constexpr const char isa[] = "sse2";
+  MP2_TARGET("sse2") static reg load(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+  MP2_TARGET("sse2") static void store(int32_t* p, reg a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a); }
+  MP2_TARGET("sse2") static reg add(reg a, reg b) { return _mm_add_epi32(a, b); }
+  MP2_TARGET("sse2") static reg sub(reg a, reg b) { return _mm_sub_epi32(a, b); }
+  MP2_TARGET("sse2") static reg set1(int32_t a) { return _mm_set1_epi32(a); }
+  MP2_TARGET("sse2") static reg zero() { return _mm_setzero_si128(); }
+};
+template<> struct TSse2<int64_t>
+{
+  using reg = __m128i;
+  static const size_t width = 2;
+  static const bool hasMul = false;
+  static constexpr const char isa[] = "sse2";
+  MP2_TARGET("sse2") static reg load(const int64_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+  MP2_TARGET("sse2") static void store(int64_t* p, reg a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a); }
+  MP2_TARGET("sse2") static reg add(reg a, reg b) { return _mm_add_epi64(a, b); }
+  MP2_TARGET("sse2") static reg sub(reg a, reg b) { return _mm_sub_epi64(a, b); }
+  MP2_TARGET("sse2") static reg set1(int64_t a) { return _mm_set1_epi64x(a); }
+  MP2_TARGET("sse2") static reg zero() { return _mm_setzero_si128(); }
+};
+
+template<> struct TAvx2<float>
+{
+  using reg = __m256;
+  static const size_t width = 8;
+  static const bool hasMul = true;
+  static constexpr const char isa[] = "avx2,fma";
+  MP2_TARGET("avx2") static reg load(const float* p) { return _mm256_loadu_ps(p); }
+  MP2_TARGET("avx2") static void store(float* p, reg a) { _mm256_storeu_ps(p, a); }
+  MP2_TARGET("avx2") static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+  MP2_TARGET("avx2") static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+  MP2_TARGET("avx2") static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+  MP2_TARGET("avx2,fma") static reg fma(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+  MP2_TARGET("avx2") static reg set1(float a) { return _mm256_set1_ps(a); }
+  MP2_TARGET("avx2") static reg zero() { return _mm256_setzero_ps(); }
+};
+template<> struct TAvx2<double>
+{
+  using reg = __m256d;
+  static const size_t width = 4;
+  static const bool hasMul = true;
+  static constexpr const char isa[] = "avx2,fma";
+  MP2_TARGET("avx2") static reg load(const double* p) { return _mm256_loadu_pd(p); }
+  MP2_TARGET("avx2") static void store(double* p, reg a) { _mm256_storeu_pd(p, a); }
+  MP2_TARGET("avx2") static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+  MP2_TARGET("avx2") static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+  MP2_TARGET("avx2") static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+  MP2_TARGET("avx2,fma") static reg fma(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+  MP2_TARGET("avx2") static reg set1(double a) { return _mm256_set1_pd(a); }
+  MP2_TARGET("avx2") static reg zero() { return _mm256_setzero_pd(); }
+};
+template<> struct TAvx2<int32_t>
+{
+  using reg = __m256i;
+  static const size_t width = 8;
+  static const bool hasMul = true;
+  static constexpr const char isa[] = "avx2,fma";
+  MP2_TARGET("avx2") static reg load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+  MP2_TARGET("avx2") static void store(int32_t* p, reg a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a); }
+  MP2_TARGET("avx2") static reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+  MP2_TARGET("avx2") static reg sub(reg a, reg b) { return _mm256_sub_epi32(a, b); }
+  MP2_TARGET("avx2") static reg mul(reg a, reg b) { return _mm256_mullo_epi32(a, b); }
+  MP2_TARGET("avx2") static reg fma(reg a, reg b, reg c) { return add(mul(a, b), c); }
+  MP2_TARGET("avx2") static reg set1(int32_t a) { return _mm256_set1_epi32(a); }
+  MP2_TARGET("avx2") static reg zero() { return _mm256_setzero_si256(); }
+};
+template<> struct TAvx2<int64_t>
+{
+  using reg = __m256i;
+  static const size_t width = 4;
+  static const bool hasMul = false; // mullo_epi64 - только с AVX-512DQ
+  static constexpr const char isa[] = "avx2,fma";
+  MP2_TARGET("avx2") static reg load(const int64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+  MP2_TARGET("avx2") static void store(int64_t* p, reg a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a); }
+  MP2_TARGET("avx2") static reg add(reg a, reg b) { return _mm256_add_epi64(a, b); }
+  MP2_TARGET("avx2") static reg sub(reg a, reg b) { return _mm256_sub_epi64(a, b); }
+  MP2_TARGET("avx2") static reg set1(int64_t a) { return _mm256_set1_epi64x(a); }
+  MP2_TARGET("avx2") static reg zero() { return _mm256_setzero_si256(); }
+};
+
+template<> struct TAvx512<float>
+{
+  using reg = __m512;
+  static const size_t width = 16;
+  static const bool hasMul = true;
+  static constexpr const char isa[] = "avx512f,avx512dq";
+  MP2_TARGET("avx512f") static reg load(const float* p) { return _mm512_loadu_ps(p); }
+  MP2_TARGET("avx512f") static void store(float* p, reg a) { _mm512_storeu_ps(p, a); }
+  MP2_TARGET("avx512f") static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+  MP2_TARGET("avx512f") static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+  MP2_TARGET("avx512f") static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+  MP2_TARGET("avx512f") static reg fma(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+  MP2_TARGET("avx512f") static reg set1(float a) { return _mm512_set1_ps(a); }
+  MP2_TARGET("avx512f") static reg zero() { return _mm512_setzero_ps(); }
+};
+template<> struct TAvx512<double>
+{
+  using reg = __m512d;
+  static const size_t width = 8;
+  static const bool hasMul = true;
+  static constexpr const char isa[] = "avx512f,avx512dq";
+  MP2_TARGET("avx512f") static reg load(const double* p) { return _mm512_loadu_pd(p); }
+  MP2_TARGET("avx512f") static void store(double* p, reg a) { _mm512_storeu_pd(p, a); }
+  MP2_TARGET("avx512f") static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+  MP2_TARGET("avx512f") static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+  MP2_TARGET("avx512f") static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+  MP2_TARGET("avx512f") static reg fma(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+  MP2_TARGET("avx512f") static reg set1(double a) { return _mm512_set1_pd(a); }
+  MP2_TARGET("avx512f") static reg zero() { return _mm512_setzero_pd(); }
+};
+template<> struct TAvx512<int32_t>
+{
+  using reg = __m512i;
+  static const size_t width = 16;
+  static const bool hasMul = true;
+  static constexpr const char isa[] = "avx512f,avx512dq";
+  MP2_TARGET("avx512f") static reg load(const int32_t* p) { return _mm512_loadu_si512(p); }
+  MP2_TARGET("avx512f") static void store(int32_t* p, reg a) { _mm512_storeu_si512(p, a); }
+  MP2_TARGET("avx512f") static reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+  MP2_TARGET("avx512f") static reg sub(reg a, reg b) { return _mm512_sub_epi32(a, b); }
+  MP2_TARGET("avx512f") static reg mul(reg a, reg b) { return _mm512_mullo_epi32(a, b); }
+  MP2_TARGET("avx512f") static reg fma(reg a, reg b, reg c) { return add(mul(a, b), c); }
+  MP2_TARGET("avx512f") static reg set1(int32_t a) { return _mm512_set1_epi32(a); }
+  MP2_TARGET("avx512f") static reg zero() { return _mm512_setzero_si512(); }
+};
+template<> struct TAvx512<int64_t>
+{
+  using reg = __m512i;
+  static const size_t width = 8;
+  static const bool hasMul = true;
+  static constexpr const char isa[] = "avx512f,avx512dq";
+  MP2_TARGET("avx512f,avx512dq") static reg load(const int64_t* p) { return _mm512_loadu_si512(p); }
+  MP2_TARGET("avx512f,avx512dq") static void store(int64_t* p, reg a) { _mm512_storeu_si512(p, a); }
+  MP2_TARGET("avx512f,avx512dq") static reg add(reg a, reg b) { return _mm512_add_epi64(a, b); }
+  MP2_TARGET("avx512f,avx512dq") static reg sub(reg a, reg b) { return _mm512_sub_epi64(a, b); }
+  MP2_TARGET("avx512f,avx512dq") static reg mul(reg a, reg b) { return _mm512_mullo_epi64(a, b); }
+  MP2_TARGET("avx512f,avx512dq") static reg fma(reg a, reg b, reg c) { return add(mul(a, b), c); }
+  MP2_TARGET("avx512f,avx512dq") static reg set1(int64_t a) { return _mm512_set1_epi64(a); }
+  MP2_TARGET("avx512f,avx512dq") static reg zero() { return _mm512_setzero_si512(); }
+};
+
+// Ядра над регистрами V (встраиваются в функции-входы уровня);
+// хвост короче регистра обрабатывается поэлементно
+template<typename V, typename T>
+struct TSimdKernels
+{
+  MP2_KERNEL(V) static void add(const T* a, const T* b, T* r, size_t n)
+  {
+    size_t i = 0;
+    for (; i + V::width <= n; i += V::width)
+      V::store(r + i, V::add(V::load(a + i), V::load(b + i)));
+    for (; i < n; i++)
+      r[i] = a[i] + b[i];
+  }
+  MP2_KERNEL(V) static void sub(const T* a, const T* b, T* r, size_t n)
+  {
+    size_t i = 0;
+    for (; i + V::width <= n; i += V::width)
+      V::store(r + i, V::sub(V::load(a + i), V::load(b + i)));
+    for (; i < n; i++)
+      r[i] = a[i] - b[i];
+  }
+  // четыре независимых накопителя скрывают задержку сложения;
+  // порядок суммирования отличается от последовательного
+  MP2_KERNEL(V) static T dot(const T* a, const T* b, size_t n)
+  {
+    size_t i = 0;
+    T res = T();
+    if constexpr (V::hasMul)
+    {
+      typename V::reg s0 = V::zero(), s1 = V::zero(), s2 = V::zero(), s3 = V::zero();
+      for (; i + 4 * V::width <= n; i += 4 * V::width)
+      {
+        s0 = V::fma(V::load(a + i), V::load(b + i), s0);
+        s1 = V::fma(V::load(a + i + V::width), V::load(b + i + V::width), s1);
+        s2 = V::fma(V::load(a + i + 2 * V::width), V::load(b + i + 2 * V::width), s2);
+        s3 = V::fma(V::load(a + i + 3 * V::width), V::load(b + i + 3 * V::width), s3);
+      }
+      for (; i + V::width <= n; i += V::width)
+        s0 = V::fma(V::load(a + i), V::load(b + i), s0);
+      T lanes[V::width];
+      V::store(lanes, V::add(V::add(s0, s1), V::add(s2, s3)));
+      for (size_t k = 0; k < V::width; k++)
+        res += lanes[k];
+    }
+    for (; i < n; i++)
+      res += a[i] * b[i];
+    return res;
+  }
+};
+
+// входы уровней: весь код ядра встраивается и собирается под набор уровня
+template<typename T>
+struct TSse2Kernels
+{
+  MP2_SIMD_ENTRY("sse2") static void add(const T* a, const T* b, T* r, size_t n) { TSimdKernels<TSse2<T>, T>::add(a, b, r, n); }
+  MP2_SIMD_ENTRY("sse2") static void sub(const T* a, const T* b, T* r, size_t n) { TSimdKernels<TSse2<T>, T>::sub(a, b, r, n); }
+  MP2_SIMD_ENTRY("sse2") static T dot(const T* a, const T* b, size_t n) { return TSimdKernels<TSse2<T>, T>::dot(a, b, n); }
+};
+template<typename T>
+struct TAvx2Kernels
+{
+  MP2_SIMD_ENTRY("avx2,fma") static void add(const T* a, const T* b, T* r, size_t n) { TSimdKernels<TAvx2<T>, T>::add(a, b, r, n); }
+  MP2_SIMD_ENTRY("avx2,fma") static void sub(const T* a, const T* b, T* r, size_t n) { TSimdKernels<TAvx2<T>, T>::sub(a, b, r, n); }
+  MP2_SIMD_ENTRY("avx2,fma") static T dot(const T* a, const T* b, size_t n) { return TSimdKernels<TAvx2<T>, T>::dot(a, b, n); }
+};
+template<typename T>
+struct TAvx512Kernels
+{
+  MP2_SIMD_ENTRY("avx512f,avx512dq") static void add(const T* a, const T* b, T* r, size_t n) { TSimdKernels<TAvx512<T>, T>::add(a, b, r, n); }
+  MP2_SIMD_ENTRY("avx512f,avx512dq") static void sub(const T* a, const T* b, T* r, size_t n) { TSimdKernels<TAvx512<T>, T>::sub(a, b, r, n); }
+  MP2_SIMD_ENTRY("avx512f,avx512dq") static T dot(const T* a, const T* b, size_t n) { return TSimdKernels<TAvx512<T>, T>::dot(a, b, n); }
+};
+
+#endif
+
+// типы, для которых есть векторные ядра
+template<typename T>
+struct TIsSimdType
+{
+  static const bool value = std::is_same<T, float>::value || std::is_same<T, double>::value ||
+    std::is_same<T, int32_t>::value || std::is_same<T, int64_t>::value;
+};
+
+// r = a + b, r = a - b, a . b над n элементами
+// (r может совпадать с a или b)
+template<typename T>
+void simd_add(const T* a, const T* b, T* r, size_t n)
+{
+#ifdef MP2_SIMD_X86
+  if constexpr (TIsSimdType<T>::value)
+    switch (simd_level())
+    {
+    case SIMD_AVX512: TAvx512Kernels<T>::add(a, b, r, n); return;
+    case SIMD_AVX2: TAvx2Kernels<T>::add(a, b, r, n); return;
+    case SIMD_SSE2: TSse2Kernels<T>::add(a, b, r, n); return;
+    default: break;
+    }
+#endif
+  for (size_t i = 0; i < n; i++)
+    r[i] = a[i] + b[i];
+}
+template<typename T>
+void simd_sub(const T* a, const T* b, T* r, size_t n)
+{
+#ifdef MP2_SIMD_X86
+  if constexpr (TIsSimdType<T>::value)
+    switch (simd_level())
+    {
+    case SIMD_AVX512: TAvx512Kernels<T>::sub(a, b, r, n); return;
+    case SIMD_AVX2: TAvx2Kernels<T>::sub(a, b, r, n); return;
+    case SIMD_SSE2: TSse2Kernels<T>::sub(a, b, r, n); return;
+    default: break;
+    }
+#endif
+  for (size_t i = 0; i < n; i++)
+    r[i] = a[i] - b[i];
+}
+template<typename T>
+T simd_dot(const T* a, const T* b, size_t n)
+{
+#ifdef MP2_SIMD_X86
+  if constexpr (TIsSimdType<T>::value)
+    switch (simd_level())
+    {
+    case SIMD_AVX512: return TAvx512Kernels<T>::dot(a, b, n);
+    case SIMD_AVX2: return TAvx2Kernels<T>::dot(a, b, n);
+    case SIMD_SSE2: return TSse2Kernels<T>::dot(a, b, n);
+    default: break;
+    }
+#endif
+  T res = T();
+  for (size_t i = 0; i < n; i++)
+    res += a[i] * b[i];
+  return res;
+}
+
+#endif
@@ -0,0 +1,155 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+//
+
+#ifndef __TUpperTriangularMatrix_H__
+#define __TUpperTriangularMatrix_H__
+
+#include "tmatrix.h"
+
+// Верхнетреугольная матрица -
+// хранит только n(n+1)/2 элементов a[i][j], j >= i, упакованных по строкам.
+// Строка i занимает n - i элементов и начинается со смещения
+// i * n - i * (i - 1) / 2 в буфере
+template<typename T, typename Alloc = TAlignedAllocator<T>>
+class TUpperTriangularMatrix : private TDynamicVector<T, Alloc, 0>
+{
+  using TDynamicVector<T, Alloc, 0>::pMem;
+
+  size_t dim;
+
+  static size_t CheckedSize(size_t s)
+  {
+    if (s == 0)
+      throw out_of_range("Matrix size should be greater than zero");
+    if (s > MAX_MATRIX_SIZE)
+      throw out_of_range("Matrix size should not exceed MAX_MATRIX_SIZE");
+    return s * (s + 1) / 2;
+  }
+
+  // смещение начала строки i в упакованном буфере
+  size_t RowOffset(size_t i) const noexcept { return i * dim - i * (i - 1) / 2; }
+
+  TUpperTriangularMatrix(TDynamicVector<T, Alloc, 0>&& v, size_t s) : TDynamicVector<T, Alloc, 0>(std::move(v)), dim(s) {}
+public:
+  TUpperTriangularMatrix(size_t s = 1) : TDynamicVector<T, Alloc, 0>(CheckedSize(s)), dim(s)
+  {
+  }
+
+  size_t size() const noexcept { return dim; }
+
+  // индексация: m[i][j] допустима только при j >= i, без контроля
+  T* operator[](size_t ind)
+  {
+    return pMem + RowOffset(ind) - ind;
+  }
+  const T* operator[](size_t ind) const
+  {
+    return pMem + RowOffset(ind) - ind;
+  }
+  // индексация с контролем; элементы под диагональю не хранятся
+  T& at(size_t i, size_t j)
+  {
+    if (i >= dim || j >= dim || j < i)
+      throw out_of_range("Matrix index is out of range");
+    return pMem[RowOffset(i) + j - i];
+  }
+  const T& at(size_t i, size_t j) const
+  {
+    if (i >= dim || j >= dim || j < i)
+      throw out_of_range("Matrix index is out of range");
+    return pMem[RowOffset(i) + j - i];
+  }
+
+  // сравнение
+  bool operator==(const TUpperTriangularMatrix& m) const noexcept
+  {
+    return dim == m.dim && TDynamicVector<T, Alloc, 0>::operator==(m);
+  }
+  bool operator!=(const TUpperTriangularMatrix& m) const noexcept
+  {
+    return !(*this == m);
+  }
+
+  // матрично-скалярные операции
+  TUpperTriangularMatrix operator*(const T& val) const
+  {
+    return TUpperTriangularMatrix(TDynamicVector<T, Alloc, 0>::operator*(val), dim);
+  }
+
+  // матрично-векторные операции: строка i умножается только на v[i..n-1]
+  TDynamicVector<T, Alloc> operator*(const TDynamicVector<T, Alloc>& v) const
+  {
+    if (dim != v.size())
+      throw length_error("Matrix and vector sizes should be compatible");
+    TDynamicVector<T, Alloc> res(dim, NO_INIT);
+    const T* row = pMem;
+    for (size_t i = 0; i < dim; i++)
+    {
+      T sum = T();
+      for (size_t j = i; j < dim; j++)
+        sum += row[j - i] * v[j];
+      res[i] = sum;
+      row += dim - i;
+    }
+    return res;
+  }
+
+  // матрично-матричные операции
+  TUpperTriangularMatrix operator+(const TUpperTriangularMatrix& m) const
+  {
+    if (dim != m.dim)
+      throw length_error("Matrices should have equal sizes");
+    return TUpperTriangularMatrix(TDynamicVector<T, Alloc, 0>::operator+(m), dim);
+  }
+  TUpperTriangularMatrix operator-(const TUpperTriangularMatrix& m) const
+  {
+    if (dim != m.dim)
+      throw length_error("Matrices should have equal sizes");
+    return TUpperTriangularMatrix(TDynamicVector<T, Alloc, 0>::operator-(m), dim);
+  }
+  // произведение верхнетреугольных матриц - верхнетреугольная матрица:
+  // c[i][j] = sum(a[i][k] * b[k][j]), i <= k <= j
+  TUpperTriangularMatrix operator*(const TUpperTriangularMatrix& m) const
+  {
+    if (dim != m.dim)
+      throw length_error("Matrices should have equal sizes");
+    TUpperTriangularMatrix res(dim);
+    for (size_t i = 0; i < dim; i++)
+    {
+      T* rrow = res[i];
+      const T* arow = (*this)[i];
+      for (size_t k = i; k < dim; k++)
+      {
+        const T a = arow[k];
+        const T* mrow = m[k];
+        for (size_t j = k; j < dim; j++)
+          rrow[j] += a * mrow[j];
+      }
+    }
+    return res;
+  }
+
+  // ввод/вывод: вводятся только элементы на диагонали и над ней,
+  // выводится полная матрица
+  friend istream& operator>>(istream& istr, TUpperTriangularMatrix& v)
+  {
+    for (size_t i = 0; i < v.size() * (v.size() + 1) / 2; i++)
+      istr >> v.pMem[i]; // требуется оператор>> для типа T
+    return istr;
+  }
+  friend ostream& operator<<(ostream& ostr, const TUpperTriangularMatrix& v)
+  {
+    for (size_t i = 0; i < v.dim; i++)
+    {
+      for (size_t j = 0; j < v.dim; j++)
+        ostr << (j < i ? T() : v[i][j]) << ' '; // требуется оператор<< для типа T
+      ostr << endl;
+    }
+    return ostr;
+  }
+};
+
+#endif
@@ -5,12 +5,12 @@
 // Тестирование матриц
 
 #include <iostream>
-#include "tmatrix.h"
+#include "utmatrix.h"
 //---------------------------------------------------------------------------
 
 int main()
 {
-  TDynamicMatrix<int> a(5), b(5), c(5);
+  TUpperTriangularMatrix<int> a(5), b(5), c(5);
   int i, j;
 
   setlocale(LC_ALL, "Russian");
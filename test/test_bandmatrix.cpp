@@ -0,0 +1,104 @@
+#include "bandmatrix.h"
+
+#include <gtest.h>
+
+TEST(TBandMatrix, can_create_matrix_with_positive_length)
+{
+  ASSERT_NO_THROW(TBandMatrix<double> m(1000000, 2, 3));
+}
+
+TEST(TBandMatrix, throws_when_bandwidth_is_too_large)
+{
+  ASSERT_ANY_THROW(TBandMatrix<double> m(3, 3, 0));
+}
+
+TEST(TBandMatrix, can_set_and_get_element_inside_band)
+{
+  TBandMatrix<int> m(5, 1, 2);
+  m[3][2] = 4;
+  m[1][3] = 6;
+
+  EXPECT_EQ(4, m.at(3, 2));
+  EXPECT_EQ(6, m.at(1, 3));
+}
+
+TEST(TBandMatrix, throws_when_access_element_outside_band)
+{
+  TBandMatrix<int> m(5, 1, 2);
+
+  ASSERT_ANY_THROW(m.at(3, 1) = 1);
+  ASSERT_ANY_THROW(m.at(0, 3) = 1);
+}
+
+TEST(TBandMatrix, can_add_matrices_with_equal_bands)
+{
+  TBandMatrix<int> m(3, 1, 1), m1(3, 1, 1);
+  m[1][0] = 1; m1[1][0] = 2;
+
+  EXPECT_EQ(3, (m + m1)[1][0]);
+}
+
+TEST(TBandMatrix, cant_add_matrices_with_different_bands)
+{
+  TBandMatrix<int> m(3, 1, 1), m1(3, 0, 1);
+
+  ASSERT_ANY_THROW(m + m1);
+}
+
+TEST(TBandMatrix, product_with_vector_matches_dense_product)
+{
+  const size_t n = 6;
+  TBandMatrix<int> m(n, 2, 1);
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = (i > 2 ? i - 2 : 0); j <= std::min(n - 1, i + 1); j++)
+      m[i][j] = int(i * n + j + 1);
+  TDynamicVector<int> v(n);
+  for (size_t i = 0; i < n; i++)
+    v[i] = int(i) - 2;
+
+  EXPECT_EQ(m.dense() * v, m * v);
+}
+
+TEST(TBandMatrix, can_solve_tridiagonal_system)
+{
+  const size_t n = 50;
+  TBandMatrix<double> m(n, 1, 1);
+  TDynamicVector<double> x(n);
+  for (size_t i = 0; i < n; i++)
+  {
+    m[i][i] = 4;
+    if (i > 0) m[i][i - 1] = -1;
+    if (i + 1 < n) m[i][i + 1] = -1.5;
+    x[i] = double(i % 7) - 3;
+  }
+  TDynamicVector<double> res = m.solve(m * x);
+
+  for (size_t i = 0; i < n; i++)
+    EXPECT_NEAR(x[i], res[i], 1e-10);
+}
+
+TEST(TBandMatrix, can_solve_banded_system)
+{
+  const size_t n = 40;
+  TBandMatrix<double> m(n, 2, 3);
+  TDynamicVector<double> x(n);
+  for (size_t i = 0; i < n; i++)
+  {
+    for (size_t j = (i > 2 ? i - 2 : 0); j <= std::min(n - 1, i + 3); j++)
+      m[i][j] = (i == j) ? 10.0 : 1.0 / double(i + j + 1);
+    x[i] = double(i) * 0.5 - 7;
+  }
+  TDynamicVector<double> res = m.solve(m * x);
+
+  for (size_t i = 0; i < n; i++)
+    EXPECT_NEAR(x[i], res[i], 1e-10);
+}
+
+TEST(TBandMatrix, throws_when_solve_meets_zero_pivot)
+{
+  TBandMatrix<double> m(3, 1, 1);
+  TDynamicVector<double> b(3);
+
+  ASSERT_ANY_THROW(m.solve(b));
+}
+
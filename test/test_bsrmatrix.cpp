@@ -0,0 +1,155 @@
+#include "bsrmatrix.h"
+
+#include <gtest.h>
+
+using TBsr2 = TBlockSparseMatrix<int, 2>;
+using TBsr4 = TBlockSparseMatrix<int, 4>;
+using TBsr8 = TBlockSparseMatrix<int, 8>;
+
+TEST(TBlockSparseMatrix, can_create_matrix_with_positive_size)
+{
+  ASSERT_NO_THROW(TBsr4 m(1000000, 1000000));
+}
+
+TEST(TBlockSparseMatrix, throws_when_create_matrix_with_zero_size)
+{
+  ASSERT_ANY_THROW(TBsr4 m(0, 5));
+}
+
+TEST(TBlockSparseMatrix, can_create_matrix_from_triplets)
+{
+  TBsr2 m(4, 6, { { 3, 5, 7 }, { 0, 0, 1 }, { 1, 1, 2 }, { 2, 4, 3 } });
+
+  EXPECT_EQ(2u, m.blocks());
+  EXPECT_EQ(1, m.at(0, 0));
+  EXPECT_EQ(2, m.at(1, 1));
+  EXPECT_EQ(3, m.at(2, 4));
+  EXPECT_EQ(7, m.at(3, 5));
+  EXPECT_EQ(0, m.at(0, 1));
+  EXPECT_EQ(0, m.at(2, 2));
+}
+
+TEST(TBlockSparseMatrix, duplicate_triplets_are_summed)
+{
+  TBsr2 m(2, 2, { { 1, 1, 2 }, { 0, 1, 1 }, { 1, 1, 3 } });
+
+  EXPECT_EQ(1u, m.blocks());
+  EXPECT_EQ(5, m.at(1, 1));
+}
+
+TEST(TBlockSparseMatrix, throws_when_triplet_is_out_of_range)
+{
+  ASSERT_ANY_THROW(TBsr2 m(3, 3, { { 3, 0, 1 } }));
+}
+
+TEST(TBlockSparseMatrix, can_convert_to_and_from_dense_matrix_with_partial_blocks)
+{
+  TDynamicMatrix<int> d(5, 7);
+  d[0][1] = 4; d[4][6] = -1; d[2][3] = 2;
+  TBsr4 m(d);
+
+  EXPECT_EQ(2u, m.blocks());
+  EXPECT_EQ(d, m.dense());
+}
+
+TEST(TBlockSparseMatrix, can_multiply_matrix_by_scalar)
+{
+  TBsr2 m(2, 2, { { 0, 1, 3 } });
+
+  EXPECT_EQ(6, (m * 2).at(0, 1));
+}
+
+TEST(TBlockSparseMatrix, product_matches_dense_product)
+{
+  const size_t n = 19;
+  TDynamicMatrix<int> d(n, n);
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < n; j++)
+      if ((i / 8 + j / 8) % 2 == 0)
+        d[i][j] = int(i * n + j) % 7 - 3;
+  TDynamicVector<int> v(n);
+  for (size_t i = 0; i < n; i++)
+    v[i] = int(i) - 5;
+
+  EXPECT_EQ(d * v, TBsr4(d) * v);
+  EXPECT_EQ(d * v, TBsr8(d) * v);
+}
+
+TEST(TBlockSparseMatrix, can_multiply_by_strided_view)
+{
+  TBsr2 m(2, 3, { { 0, 0, 1 }, { 1, 2, 2 } });
+  TDynamicVector<int> v(6), res(2);
+  for (size_t i = 0; i < 6; i++)
+    v[i] = int(i);
+  res[0] = 0; res[1] = 8;
+
+  EXPECT_EQ(res, m * v.slice(0, 3, 2));
+}
+
+TEST(TBlockSparseMatrix, throws_when_multiply_by_vector_with_wrong_size)
+{
+  TBsr4 m(4, 4);
+  TDynamicVector<int> v(5);
+
+  ASSERT_ANY_THROW(m * v);
+}
+
+TEST(TBlockSparseMatrix, product_of_double_matrix_matches_dense_product)
+{
+  const size_t n = 21;
+  TDynamicMatrix<double> d(n, n);
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < n; j++)
+      if ((i / 4 + j / 4) % 3 == 0)
+        d[i][j] = double(int(i * n + j) % 9 - 4);
+  TDynamicVector<double> v(n);
+  for (size_t i = 0; i < n; i++)
+    v[i] = double(i) - 7;
+
+  EXPECT_EQ(d * v, (TBlockSparseMatrix<double, 4>(d) * v));
+  EXPECT_EQ(d * v, (TBlockSparseMatrix<double, 8>(d) * v));
+  EXPECT_EQ(d * v, (TBlockSparseMatrix<double, 16>(d) * v));
+}
+
+TEST(TBlockSparseMatrix, matrix_product_matches_dense_product)
+{
+  const size_t r = 13, c = 10, n = 19;
+  TDynamicMatrix<int> d(r, c), x(c, n);
+  for (size_t i = 0; i < r; i++)
+    for (size_t j = 0; j < c; j++)
+      if ((i / 4 + j / 4) % 2 == 0)
+        d[i][j] = int(i * c + j) % 7 - 3;
+  for (size_t i = 0; i < c; i++)
+    for (size_t j = 0; j < n; j++)
+      x[i][j] = int(i + 2 * j) % 5 - 2;
+  TDynamicMatrix<int> expected = d * x;
+
+  EXPECT_EQ(expected, TBsr2(d) * x);
+  EXPECT_EQ(expected, TBsr4(d) * x);
+  EXPECT_EQ(expected, TBsr8(d) * x);
+}
+
+TEST(TBlockSparseMatrix, double_matrix_product_matches_dense_product)
+{
+  const size_t r = 12, c = 17, n = 9;
+  TDynamicMatrix<double> d(r, c), x(c, n);
+  for (size_t i = 0; i < r; i++)
+    for (size_t j = 0; j < c; j++)
+      if ((i / 8 + j / 8) % 2 == 1)
+        d[i][j] = double(int(i * c + j) % 7 - 3);
+  for (size_t i = 0; i < c; i++)
+    for (size_t j = 0; j < n; j++)
+      x[i][j] = double(int(i * j) % 5 - 2);
+  TDynamicMatrix<double> expected = d * x;
+
+  EXPECT_EQ(expected, (TBlockSparseMatrix<double, 4>(d) * x));
+  EXPECT_EQ(expected, (TBlockSparseMatrix<double, 8>(d) * x));
+}
+
+TEST(TBlockSparseMatrix, throws_when_multiply_by_matrix_with_wrong_size)
+{
+  TBsr4 m(4, 4);
+  TDynamicMatrix<int> x(5, 3);
+
+  ASSERT_ANY_THROW(m * x);
+}
@@ -0,0 +1,109 @@
+#include "diagmatrix.h"
+
+#include <gtest.h>
+
+TEST(TDiagonalMatrix, can_create_matrix_with_positive_length)
+{
+  ASSERT_NO_THROW(TDiagonalMatrix<int> m(1000000));
+}
+
+TEST(TDiagonalMatrix, throws_when_create_matrix_with_negative_length)
+{
+  ASSERT_ANY_THROW(TDiagonalMatrix<int> m(-5));
+}
+
+TEST(TDiagonalMatrix, can_set_and_get_diagonal_element)
+{
+  TDiagonalMatrix<int> m(4);
+  m[2] = 5;
+
+  EXPECT_EQ(5, m.at(2, 2));
+  EXPECT_EQ(0, m.at(2, 1));
+}
+
+TEST(TDiagonalMatrix, throws_when_get_element_with_too_large_index)
+{
+  TDiagonalMatrix<int> m(4);
+
+  ASSERT_ANY_THROW(m.at(4, 4));
+  ASSERT_ANY_THROW(m.at(4) = 1);
+}
+
+TEST(TDiagonalMatrix, can_create_matrix_from_vector)
+{
+  TDynamicVector<int> v(3);
+  v[0] = 1; v[1] = 2; v[2] = 3;
+  TDiagonalMatrix<int> m(v);
+
+  EXPECT_EQ(3u, m.size());
+  EXPECT_EQ(2, m[1]);
+}
+
+TEST(TDiagonalMatrix, can_multiply_matrix_by_vector)
+{
+  TDiagonalMatrix<int> m(3);
+  m[0] = 2; m[1] = 3; m[2] = 4;
+  TDynamicVector<int> v(3);
+  v[0] = 1; v[1] = 1; v[2] = 2;
+
+  EXPECT_EQ(m.dense() * v, m * v);
+}
+
+TEST(TDiagonalMatrix, can_multiply_diagonal_matrices)
+{
+  TDiagonalMatrix<int> m(2), m1(2);
+  m[0] = 2; m[1] = 3;
+  m1[0] = 4; m1[1] = 5;
+
+  EXPECT_EQ(15, (m * m1)[1]);
+}
+
+TEST(TDiagonalMatrix, left_product_scales_rows)
+{
+  TDiagonalMatrix<int> d(2);
+  d[0] = 2; d[1] = 3;
+  TDynamicMatrix<int> m(2, 3);
+  for (size_t i = 0; i < 2; i++)
+    for (size_t j = 0; j < 3; j++)
+      m[i][j] = int(i * 3 + j + 1);
+
+  EXPECT_EQ(d.dense() * m, d * m);
+}
+
+TEST(TDiagonalMatrix, right_product_scales_columns)
+{
+  TDiagonalMatrix<int> d(3);
+  d[0] = 2; d[1] = 3; d[2] = -1;
+  TDynamicMatrix<int> m(2, 3);
+  for (size_t i = 0; i < 2; i++)
+    for (size_t j = 0; j < 3; j++)
+      m[i][j] = int(i * 3 + j + 1);
+
+  EXPECT_EQ(m * d.dense(), m * d);
+  EXPECT_EQ(m * d.dense(), m.block(0, 0, 2, 3) * d);
+}
+
+TEST(TDiagonalMatrix, cant_multiply_by_matrix_with_incompatible_size)
+{
+  TDiagonalMatrix<int> d(3);
+  TDynamicMatrix<int> m(2, 3);
+
+  ASSERT_ANY_THROW(d * m);
+  ASSERT_NO_THROW(m * d);
+}
+
+TEST(TDiagonalMatrix, can_multiply_by_expression)
+{
+  TDiagonalMatrix<int> d(4);
+  TDynamicVector<int> a(4);
+  TDynamicMatrix<int> m(4), m2(4);
+  for (size_t i = 0; i < 4; i++)
+  {
+    d[i] = int(i) + 1;
+    a[i] = int(i) - 2;
+    m[i][i] = 1;
+  }
+  m2 = m + m;
+  EXPECT_EQ(d * TDynamicVector<int>(a + a), d * (a + a));
+  EXPECT_EQ(d * m2, d * (m + m));
+}
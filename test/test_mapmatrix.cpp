@@ -0,0 +1,95 @@
+﻿#include "mapmatrix.h"
+
+#include <cstdio>
+#include <sstream>
+#include <gtest.h>
+
+static const char* MAPPED_FILE = "test_mapmatrix.bin";
+
+static TDynamicMatrix<double> SampleMatrix()
+{
+  TDynamicMatrix<double> m(3, 4);
+  for (size_t i = 0; i < 3; i++)
+    for (size_t j = 0; j < 4; j++)
+      m[i][j] = double(i * 4 + j) / 2;
+  return m;
+}
+
+TEST(TMappedMatrix, can_map_saved_matrix_read_only)
+{
+  TDynamicMatrix<double> m = SampleMatrix();
+  save_matrix(MAPPED_FILE, m);
+  {
+    const TDynamicMatrix<double> mm = map_matrix<double>(MAPPED_FILE);
+
+    EXPECT_EQ(3u, mm.rows());
+    EXPECT_EQ(4u, mm.cols());
+    EXPECT_EQ(m, mm);
+  }
+  remove(MAPPED_FILE);
+}
+
+TEST(TMappedMatrix, mapped_matrix_supports_arithmetic)
+{
+  TDynamicMatrix<double> m = SampleMatrix();
+  save_matrix(MAPPED_FILE, m);
+  {
+    const TDynamicMatrix<double> mm = map_matrix<double>(MAPPED_FILE);
+    TDynamicVector<double> v(4);
+    v[0] = 1; v[3] = 2;
+
+    EXPECT_EQ(m * v, mm * v);
+    EXPECT_EQ(m + m, mm + m);
+  }
+  remove(MAPPED_FILE);
+}
+
+TEST(TMappedMatrix, copy_on_write_does_not_change_file)
+{
+  TDynamicMatrix<double> m = SampleMatrix();
+  save_matrix(MAPPED_FILE, m);
+  {
+    TDynamicMatrix<double> mm = map_matrix<double>(MAPPED_FILE, COPY_ON_WRITE);
+    mm[1][2] = 100;
+
+    EXPECT_EQ(100, mm.at(1, 2));
+    EXPECT_EQ(m, map_matrix<double>(MAPPED_FILE));
+  }
+  remove(MAPPED_FILE);
+}
+
+TEST(TMappedMatrix, can_write_to_read_only_mapping)
+{
+  TDynamicMatrix<double> m = SampleMatrix();
+  save_matrix(MAPPED_FILE, m);
+  {
+    TDynamicMatrix<double> mm = map_matrix<double>(MAPPED_FILE);
+    mm[0][1] = -5;
+    mm = mm * 2.0;
+
+    EXPECT_EQ(-10, mm.at(0, 1));
+    EXPECT_EQ(m, map_matrix<double>(MAPPED_FILE));
+  }
+  {
+    TDynamicMatrix<double> mm = map_matrix<double>(MAPPED_FILE, READ_ONLY);
+    istringstream in("1 2 3 4 5 6 7 8 9 10 11 12");
+    in >> mm;
+
+    EXPECT_EQ(12, mm.at(2, 3));
+    EXPECT_EQ(m, map_matrix<double>(MAPPED_FILE));
+  }
+  remove(MAPPED_FILE);
+}
+
+TEST(TMappedMatrix, throws_when_file_does_not_exist)
+{
+  ASSERT_ANY_THROW(map_matrix<double>("no_such_matrix_file.bin"));
+}
+
+TEST(TMappedMatrix, throws_when_element_type_differs)
+{
+  save_matrix(MAPPED_FILE, SampleMatrix());
+
+  EXPECT_ANY_THROW(map_matrix<int>(MAPPED_FILE));
+  remove(MAPPED_FILE);
+}
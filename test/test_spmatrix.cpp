@@ -0,0 +1,93 @@
+#include "spmatrix.h"
+
+#include <gtest.h>
+
+TEST(TSparseMatrix, can_create_matrix_with_positive_size)
+{
+  ASSERT_NO_THROW(TSparseMatrix<int> m(1000000, 1000000));
+}
+
+TEST(TSparseMatrix, throws_when_create_matrix_with_zero_size)
+{
+  ASSERT_ANY_THROW(TSparseMatrix<int> m(0, 5));
+}
+
+TEST(TSparseMatrix, throws_when_create_too_large_matrix)
+{
+  ASSERT_THROW(TSparseMatrix<int> m(MAX_VECTOR_SIZE + 1, 5), out_of_range);
+  ASSERT_THROW(TSparseMatrix<int> m(size_t(-1), 5), out_of_range);
+  ASSERT_THROW(TSparseMatrix<int> m(size_t(-1), 5, vector<TTriplet<int>>()), out_of_range);
+}
+
+TEST(TSparseMatrix, can_create_matrix_from_triplets)
+{
+  TSparseMatrix<int> m(3, 4, { { 2, 1, 5 }, { 0, 3, 1 }, { 0, 0, 2 } });
+
+  EXPECT_EQ(3u, m.nnz());
+  EXPECT_EQ(2, m.at(0, 0));
+  EXPECT_EQ(1, m.at(0, 3));
+  EXPECT_EQ(5, m.at(2, 1));
+  EXPECT_EQ(0, m.at(1, 1));
+}
+
+TEST(TSparseMatrix, duplicate_triplets_are_summed)
+{
+  TSparseMatrix<int> m(2, 2, { { 1, 1, 2 }, { 0, 1, 1 }, { 1, 1, 3 } });
+
+  EXPECT_EQ(2u, m.nnz());
+  EXPECT_EQ(5, m.at(1, 1));
+}
+
+TEST(TSparseMatrix, throws_when_triplet_is_out_of_range)
+{
+  ASSERT_ANY_THROW(TSparseMatrix<int> m(2, 2, { { 2, 0, 1 } }));
+}
+
+TEST(TSparseMatrix, can_convert_to_and_from_dense_matrix)
+{
+  TDynamicMatrix<int> d(3, 2);
+  d[0][1] = 4; d[2][0] = -1;
+  TSparseMatrix<int> m(d);
+
+  EXPECT_EQ(2u, m.nnz());
+  EXPECT_EQ(d, m.dense());
+}
+
+TEST(TSparseMatrix, can_multiply_matrix_by_scalar)
+{
+  TSparseMatrix<int> m(2, 2, { { 0, 1, 3 } });
+
+  EXPECT_EQ(6, (m * 2).at(0, 1));
+}
+
+TEST(TSparseMatrix, spmv_matches_dense_product)
+{
+  TDynamicMatrix<int> d(4, 5);
+  d[0][0] = 1; d[0][4] = 2; d[1][2] = 3; d[3][1] = 4; d[3][3] = 5;
+  TSparseMatrix<int> m(d);
+  TDynamicVector<int> v(5);
+  for (size_t i = 0; i < 5; i++)
+    v[i] = int(i + 1);
+
+  EXPECT_EQ(d * v, m * v);
+}
+
+TEST(TSparseMatrix, can_multiply_by_vector_view)
+{
+  TSparseMatrix<int> m(2, 2, { { 0, 0, 1 }, { 1, 1, 2 } });
+  TDynamicVector<int> v(4);
+  v[1] = 3; v[3] = 4;
+  TDynamicVector<int> res = m * v.slice(1, 2, 2);
+
+  EXPECT_EQ(3, res[0]);
+  EXPECT_EQ(8, res[1]);
+}
+
+TEST(TSparseMatrix, cant_multiply_by_vector_with_not_equal_size)
+{
+  TSparseMatrix<int> m(2, 3);
+  TDynamicVector<int> v(2);
+
+  ASSERT_ANY_THROW(m * v);
+}
+
@@ -0,0 +1,92 @@
+#include "symmatrix.h"
+
+#include <gtest.h>
+
+TEST(TSymmetricMatrix, can_create_matrix_with_positive_length)
+{
+  ASSERT_NO_THROW(TSymmetricMatrix<int> m(5));
+}
+
+TEST(TSymmetricMatrix, cant_create_too_large_matrix)
+{
+  ASSERT_ANY_THROW(TSymmetricMatrix<int> m(MAX_MATRIX_SIZE + 1));
+}
+
+TEST(TSymmetricMatrix, mirrored_elements_share_storage)
+{
+  TSymmetricMatrix<int> m(4);
+  m.at(3, 1) = 5;
+
+  EXPECT_EQ(5, m.at(1, 3));
+  EXPECT_EQ(&m.at(1, 3), &m.at(3, 1));
+}
+
+TEST(TSymmetricMatrix, throws_when_set_element_with_too_large_index)
+{
+  TSymmetricMatrix<int> m(4);
+
+  ASSERT_ANY_THROW(m.at(4, 0) = 1);
+}
+
+TEST(TSymmetricMatrix, can_add_matrices_with_equal_size)
+{
+  TSymmetricMatrix<int> m(2), m1(2);
+  m[0][1] = 1; m1[0][1] = 2;
+
+  EXPECT_EQ(3, (m + m1).at(1, 0));
+}
+
+TEST(TSymmetricMatrix, cant_add_matrices_with_not_equal_size)
+{
+  TSymmetricMatrix<int> m(2), m1(3);
+
+  ASSERT_ANY_THROW(m + m1);
+}
+
+TEST(TSymmetricMatrix, product_with_vector_matches_dense_product)
+{
+  const size_t n = 6;
+  TSymmetricMatrix<int> m(n);
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = i; j < n; j++)
+      m[i][j] = int(i * 3 + j) - 4;
+  TDynamicVector<int> v(n);
+  for (size_t i = 0; i < n; i++)
+    v[i] = int(i) + 1;
+
+  EXPECT_EQ(m.dense() * v, m * v);
+}
+
+TEST(TSymmetricMatrix, rank_k_update_matches_dense_product)
+{
+  TDynamicMatrix<int> a(3, 2), at(2, 3);
+  for (size_t i = 0; i < 3; i++)
+    for (size_t j = 0; j < 2; j++)
+      a[i][j] = at[j][i] = int(i + 2 * j) - 1;
+  TSymmetricMatrix<int> m(3);
+  m[0][2] = 1;
+  TDynamicMatrix<int> expected = m.dense() + (a * at) * 2;
+  m.rank_update(a, 2);
+
+  EXPECT_EQ(expected, m.dense());
+}
+
+TEST(TSymmetricMatrix, rank_1_update_adds_outer_product)
+{
+  TDynamicVector<int> x(3);
+  x[0] = 1; x[1] = 2; x[2] = 3;
+  TSymmetricMatrix<int> m(3);
+  m.rank_update(x);
+
+  EXPECT_EQ(6, m.at(2, 1));
+  EXPECT_EQ(9, m.at(2, 2));
+}
+
+TEST(TSymmetricMatrix, cant_update_with_incompatible_matrix)
+{
+  TDynamicMatrix<int> a(2, 3);
+  TSymmetricMatrix<int> m(3);
+
+  ASSERT_ANY_THROW(m.rank_update(a));
+}
+
@@ -0,0 +1,114 @@
+#include "tmatrix.h"
+
+#include <gtest.h>
+
+static TDynamicMatrix<bool> SampleBitMatrix(size_t r, size_t c)
+{
+  TDynamicMatrix<bool> m(r, c);
+  for (size_t i = 0; i < r; i++)
+    for (size_t j = 0; j < c; j++)
+      m[i][j] = (i * 7 + j * 13) % 5 == 0;
+  return m;
+}
+
+TEST(TBitMatrix, packs_64_elements_per_word)
+{
+  TDynamicMatrix<bool> m(10, 130);
+
+  EXPECT_EQ(3u, m.words());
+  EXPECT_EQ(0u, m.count());
+}
+
+TEST(TBitMatrix, can_set_and_get_element)
+{
+  TDynamicMatrix<bool> m(3, 100);
+  m[1][70] = true;
+  m.at(2, 99) = true;
+  m[1][70] = m[2][99];
+
+  EXPECT_TRUE(m.at(1, 70));
+  EXPECT_TRUE(m[2][99]);
+  EXPECT_FALSE(m[1][69]);
+  EXPECT_EQ(2u, m.count());
+}
+
+TEST(TBitMatrix, moved_from_matrix_is_empty)
+{
+  TDynamicMatrix<bool> m = SampleBitMatrix(3, 70), m1(2);
+  TDynamicMatrix<bool> expected(m);
+  TDynamicMatrix<bool> m2(std::move(m));
+
+  EXPECT_EQ(0u, m.rows());
+  EXPECT_EQ(0u, m.words());
+  m1 = std::move(m2);
+  EXPECT_EQ(0u, m2.rows());
+  EXPECT_EQ(0u, m2.cols());
+  EXPECT_EQ(expected, m1);
+}
+
+TEST(TBitMatrix, throws_when_index_is_out_of_range)
+{
+  TDynamicMatrix<bool> m(3, 100);
+
+  ASSERT_ANY_THROW(m.at(1, 100));
+}
+
+TEST(TBitMatrix, can_compare_matrices)
+{
+  TDynamicMatrix<bool> m = SampleBitMatrix(5, 70), m1(m);
+
+  EXPECT_EQ(m, m1);
+  m1[4][69] = !m1[4][69];
+  EXPECT_NE(m, m1);
+}
+
+TEST(TBitMatrix, product_is_or_of_ands)
+{
+  TDynamicMatrix<bool> a = SampleBitMatrix(7, 90), b = SampleBitMatrix(90, 70);
+  TDynamicMatrix<bool> c = a * b;
+
+  for (size_t i = 0; i < 7; i++)
+    for (size_t j = 0; j < 70; j++)
+    {
+      bool val = false;
+      for (size_t k = 0; k < 90; k++)
+        val = val || (a[i][k] && b[k][j]);
+      EXPECT_EQ(val, c[i][j]);
+    }
+}
+
+TEST(TBitMatrix, can_multiply_by_vector)
+{
+  TDynamicMatrix<bool> m(3, 100);
+  m[0][5] = true; m[1][80] = true; m[2][99] = true;
+  TDynamicVector<bool> v(100);
+  v[80] = true; v[99] = true;
+  TDynamicVector<bool> res = m * v;
+
+  EXPECT_FALSE(res[0]);
+  EXPECT_TRUE(res[1]);
+  EXPECT_TRUE(res[2]);
+}
+
+TEST(TBitMatrix, can_transpose_matrix)
+{
+  TDynamicMatrix<bool> m = SampleBitMatrix(70, 130);
+  TDynamicMatrix<bool> t = m.transpose();
+
+  EXPECT_EQ(130u, t.rows());
+  EXPECT_EQ(70u, t.cols());
+  for (size_t i = 0; i < 70; i++)
+    for (size_t j = 0; j < 130; j++)
+      EXPECT_EQ(m[i][j], t[j][i]);
+  EXPECT_EQ(m, t.transpose());
+}
+
+TEST(TBitMatrix, sum_is_elementwise_or)
+{
+  TDynamicMatrix<bool> m(2, 2), m1(2, 2);
+  m[0][0] = true; m1[0][0] = true; m1[1][1] = true;
+  TDynamicMatrix<bool> res = m + m1;
+
+  EXPECT_EQ(2u, res.count());
+  EXPECT_TRUE(res[1][1]);
+}
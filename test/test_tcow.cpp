@@ -0,0 +1,80 @@
+#include "tcow.h"
+
+#include <gtest.h>
+
+TEST(TCopyOnWrite, copy_shares_storage)
+{
+  TCowVector<int> v(TDynamicVector<int>(1000));
+  TCowVector<int> v1(v), v2 = v1;
+
+  EXPECT_EQ(3u, v.use_count());
+  EXPECT_EQ(v.get().data(), v2.get().data());
+}
+
+TEST(TCopyOnWrite, const_access_does_not_copy)
+{
+  TCowVector<int> v(TDynamicVector<int>(1000));
+  const TCowVector<int> v1(v);
+
+  EXPECT_EQ(0, v1[5]);
+  EXPECT_EQ(0, v1.at(999));
+  EXPECT_EQ(2u, v.use_count());
+}
+
+TEST(TCopyOnWrite, write_detaches_copy)
+{
+  TCowVector<int> v(TDynamicVector<int>(1000));
+  TCowVector<int> v1(v);
+  v1[5] = 3;
+
+  EXPECT_EQ(1u, v.use_count());
+  EXPECT_EQ(1u, v1.use_count());
+  EXPECT_EQ(0, v[5]);
+  EXPECT_EQ(3, v1[5]);
+}
+
+TEST(TCopyOnWrite, unique_storage_is_written_in_place)
+{
+  TCowVector<int> v(TDynamicVector<int>(1000));
+  const int* p = v.get().data();
+  v.at(1) = 2;
+
+  EXPECT_EQ(p, v.get().data());
+}
+
+TEST(TCopyOnWrite, assignment_releases_old_storage)
+{
+  TCowVector<int> v(TDynamicVector<int>(10)), v1(v), v2(TDynamicVector<int>(5));
+  v1 = v2;
+
+  EXPECT_EQ(1u, v.use_count());
+  EXPECT_EQ(2u, v2.use_count());
+  EXPECT_EQ(5u, v1.size());
+}
+
+TEST(TCopyOnWrite, can_share_and_detach_matrix)
+{
+  TCowMatrix<int> m(TDynamicMatrix<int>(3, 4));
+  TCowMatrix<int> m1(m);
+  m1.at(2, 3) = 7;
+  m1[0][1] = 2;
+
+  EXPECT_EQ(0, m.at(2, 3));
+  EXPECT_EQ(7, m1->at(2, 3));
+  EXPECT_EQ(4u, m1->cols());
+  EXPECT_NE(m, m1);
+}
+
+TEST(TCopyOnWrite, arithmetic_uses_shared_storage)
+{
+  TDynamicMatrix<int> d(2);
+  d[0][0] = 1; d[1][1] = 2;
+  TCowMatrix<int> m(d), m1(m);
+  TDynamicVector<int> v(2);
+  v[0] = 3; v[1] = 4;
+
+  EXPECT_EQ(d + d, m + m1);
+  EXPECT_EQ(d * v, m * v);
+  EXPECT_EQ(d * 2, m * 2);
+  EXPECT_EQ(2u, m.use_count());
+}
@@ -0,0 +1,231 @@
+﻿#include "tmatrix.h"
+
+#include <gtest.h>
+
+#include <cmath>
+
+template<typename T>
+static void CheckFused(TSimdLevel level)
+{
+  set_simd_level(level);
+  for (size_t n = 1; n < 60; n += 7)
+  {
+    TDynamicVector<T> a(n), b(n), d(n), c(n);
+    for (size_t i = 0; i < n; i++)
+    {
+      a[i] = T(int(i % 11) - 5);
+      b[i] = T(int(i % 7) - 2);
+      d[i] = T(int(i % 3));
+    }
+    c = a + b * T(2) - d;
+    for (size_t i = 0; i < n; i++)
+      EXPECT_EQ(a[i] + b[i] * T(2) - d[i], c[i]);
+  }
+  set_simd_level(simd_detect());
+}
+
+TEST(TExpr, arithmetic_operators_return_expressions)
+{
+  TDynamicVector<int> a(3), b(3);
+  TDynamicMatrix<int> m(2);
+  EXPECT_TRUE(TIsExpr<decltype(a + b * 2 - a)>::value);
+  EXPECT_TRUE(TIsExpr<decltype(m + m * 3)>::value);
+  EXPECT_FALSE(TIsExpr<decltype(a * b)>::value);
+}
+
+TEST(TExpr, fused_expression_is_correct_on_all_levels)
+{
+  for (TSimdLevel level : { SIMD_NONE, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 })
+  {
+    CheckFused<double>(level);
+    CheckFused<float>(level);
+    CheckFused<int32_t>(level);
+    CheckFused<int64_t>(level);
+    CheckFused<long double>(level);
+  }
+}
+
+TEST(TExpr, sum_with_product_uses_fused_multiply_add_from_avx2)
+{
+  // (1 + 2^-30)^2 - (1 + 2^-29) = 2^-60 при одном округлении, иначе 0
+  const double x = 1 + ldexp(1.0, -30);
+  TDynamicVector<double> a(16), b(16);
+  for (size_t i = 0; i < 16; i++)
+  {
+    a[i] = -(1 + ldexp(1.0, -29));
+    b[i] = x;
+  }
+  for (TSimdLevel level : { SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 })
+  {
+    if (level > simd_detect())
+      continue;
+    set_simd_level(level);
+    const double expected = level >= SIMD_AVX2 ? ldexp(1.0, -60) : 0;
+    TDynamicVector<double> c = a + b * x, c1 = b * x + a;
+
+    EXPECT_EQ(expected, c[0]);
+    EXPECT_EQ(expected, c1[15]);
+  }
+  set_simd_level(simd_detect());
+}
+
+TEST(TExpr, expression_is_evaluated_on_assignment)
+{
+  TDynamicVector<int> a(3), b(3);
+  a[0] = 1; b[0] = 2;
+  auto e = a + b;
+  a[0] = 10;
+  TDynamicVector<int> c = e;
+  EXPECT_EQ(12, c[0]);
+}
+
+TEST(TExpr, can_assign_expression_of_itself)
+{
+  TDynamicVector<int> a(20), expected(20);
+  for (size_t i = 0; i < 20; i++)
+  {
+    a[i] = int(i);
+    expected[i] = int(i) * 3 + 1;
+  }
+  a = a + a * 2 + 1;
+  EXPECT_EQ(expected, a);
+}
+
+TEST(TExpr, can_assign_expression_of_other_size)
+{
+  TDynamicVector<int> a(30), b(30), c(2);
+  a[29] = 4; b[29] = 5;
+  c = a - b;
+  ASSERT_EQ(30u, c.size());
+  EXPECT_EQ(-1, c[29]);
+}
+
+TEST(TExpr, cant_build_expression_of_vectors_with_not_equal_size)
+{
+  TDynamicVector<int> a(3), b(4);
+  ASSERT_ANY_THROW(a + b * 2);
+  ASSERT_ANY_THROW(a * 2 - b);
+}
+
+TEST(TExpr, can_compare_expression_with_vector)
+{
+  TDynamicVector<int> a(3), b(3);
+  a[1] = 2;
+  b[1] = 4;
+  EXPECT_TRUE(a * 2 == b);
+  EXPECT_TRUE(a + a == b);
+  EXPECT_TRUE(a + b != b);
+  EXPECT_EQ(b, a * 2);
+}
+
+TEST(TExpr, matrix_expression_is_correct)
+{
+  TDynamicMatrix<double> a(5, 7), b(5, 7), c(5, 7);
+  for (size_t i = 0; i < 5; i++)
+    for (size_t j = 0; j < 7; j++)
+    {
+      a[i][j] = double(i + j);
+      b[i][j] = double(i * j);
+    }
+  c = a * 2.0 - b + a;
+  for (size_t i = 0; i < 5; i++)
+    for (size_t j = 0; j < 7; j++)
+      EXPECT_EQ(3 * a[i][j] - b[i][j], c[i][j]);
+  EXPECT_EQ(c.at(4, 6), (a * 2.0 - b + a).at(4, 6));
+}
+
+TEST(TExpr, column_major_matrix_expression_is_correct)
+{
+  using TColMatrix = TDynamicMatrix<int, TAlignedAllocator<int>, TColMajor>;
+  TDynamicMatrix<int> a(4, 3), b(4, 3);
+  for (size_t i = 0; i < 4; i++)
+    for (size_t j = 0; j < 3; j++)
+    {
+      a[i][j] = int(i * 3 + j);
+      b[i][j] = int(i) - int(j);
+    }
+  TColMatrix ca(a), cb(b);
+  TColMatrix cc = ca - cb * 3;
+  EXPECT_EQ(TDynamicMatrix<int>(a - b * 3), TDynamicMatrix<int>(cc));
+}
+
+TEST(TExpr, cant_build_expression_of_matrices_with_not_equal_size)
+{
+  TDynamicMatrix<int> a(3, 4), b(4, 3);
+  ASSERT_ANY_THROW(a + b);
+  ASSERT_ANY_THROW(a * 2 - b);
+}
+
+TEST(TExpr, can_multiply_vector_expression_by_vector)
+{
+  TDynamicVector<int> a(20), b(20);
+  int expected = 0;
+  for (size_t i = 0; i < 20; i++)
+  {
+    a[i] = int(i % 7) - 3;
+    b[i] = int(i % 5);
+    expected += (a[i] + b[i]) * b[i];
+  }
+  EXPECT_EQ(expected, (a + b) * b);
+  EXPECT_EQ(expected, b * (a + b));
+  EXPECT_EQ((a + b) * (a + b), TDynamicVector<int>(a + b) * TDynamicVector<int>(a + b));
+}
+
+TEST(TExpr, can_multiply_matrix_expression_by_vector)
+{
+  TDynamicMatrix<int> m(3, 4);
+  TDynamicVector<int> v(4);
+  for (size_t i = 0; i < 3; i++)
+    for (size_t j = 0; j < 4; j++)
+      m[i][j] = int(i * 4 + j);
+  for (size_t j = 0; j < 4; j++)
+    v[j] = int(j) - 1;
+  EXPECT_EQ(TDynamicMatrix<int>(m + m) * v, (m + m) * v);
+  EXPECT_EQ(m * TDynamicVector<int>(v + v), m * (v + v));
+}
+
+TEST(TExpr, can_multiply_matrix_expression_by_matrix)
+{
+  TDynamicMatrix<int> m(3), expected(3);
+  for (size_t i = 0; i < 3; i++)
+    for (size_t j = 0; j < 3; j++)
+      m[i][j] = int(i) - int(j * 2);
+  expected = TDynamicMatrix<int>(m + m) * m;
+  EXPECT_EQ(expected, (m + m) * m);
+  EXPECT_EQ(expected, m * (m + m));
+  EXPECT_EQ(TDynamicMatrix<int>(expected * 2), (m + m) * (m + m));
+}
+
+TEST(TExpr, can_index_matrix_expression)
+{
+  TDynamicMatrix<int> m(2, 3);
+  m[1][2] = 5;
+  EXPECT_EQ(10, (m + m)[1][2]);
+  EXPECT_EQ(3u, (m + m)[1].size());
+
+  TDynamicMatrix<int, TAlignedAllocator<int>, TColMajor> cm(m);
+  EXPECT_EQ(15, (cm * 3)[1][2]);
+}
+
+TEST(TExpr, can_use_expression_with_views)
+{
+  TDynamicVector<int> a(6), b(6);
+  TDynamicMatrix<int> m(3);
+  for (size_t i = 0; i < 6; i++)
+  {
+    a[i] = int(i);
+    b[i] = int(i) * 2;
+  }
+  for (size_t i = 0; i < 3; i++)
+    for (size_t j = 0; j < 3; j++)
+      m[i][j] = int(i + j);
+  TVectorView<int> view(a);
+  EXPECT_EQ(TDynamicVector<int>(a + b * 2), view + (b + b));
+  EXPECT_EQ(TDynamicVector<int>(a - b * 2), view - (b + b));
+  EXPECT_EQ(TDynamicVector<int>(a) * TDynamicVector<int>(b + b), view * (b + b));
+
+  TMatrixView<int> mv(m);
+  EXPECT_EQ(TDynamicMatrix<int>(m * 3), mv + (m + m));
+  EXPECT_EQ(TDynamicMatrix<int>(m * 3), m + (m + m));
+  EXPECT_EQ(TDynamicMatrix<int>(m * m * 2), mv * (m + m));
+}
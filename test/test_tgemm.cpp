@@ -0,0 +1,187 @@
+#include "tmatrix.h"
+
+#include <gtest.h>
+
+// сравнение gemm с прямым тройным циклом; значения целые, поэтому
+// результат точный при любом порядке суммирования
+template<typename T>
+static void CheckGemm(TSimdLevel level, size_t m, size_t n, size_t k)
+{
+  set_simd_level(level);
+  vector<T> a(m * k), b(k * n), c(m * n, T(1)), expected(m * n, T(1));
+  for (size_t i = 0; i < a.size(); i++)
+    a[i] = T(int(i % 13) - 6);
+  for (size_t i = 0; i < b.size(); i++)
+    b[i] = T(int(i % 7) - 3);
+  for (size_t i = 0; i < m; i++)
+    for (size_t j = 0; j < n; j++)
+      for (size_t p = 0; p < k; p++)
+        expected[i * n + j] += a[i * k + p] * b[p * n + j];
+
+  gemm(m, n, k, a.data(), k, b.data(), n, c.data(), n);
+  EXPECT_EQ(expected, c);
+  set_simd_level(simd_detect());
+}
+
+template<typename T>
+static void CheckAllLevels(size_t m, size_t n, size_t k)
+{
+  for (TSimdLevel level : { SIMD_NONE, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 })
+    CheckGemm<T>(level, m, n, k);
+}
+
+TEST(TGemm, small_product_is_correct)
+{
+  CheckAllLevels<double>(3, 5, 7);
+}
+
+TEST(TGemm, blocked_product_with_edges_is_correct)
+{
+  CheckAllLevels<double>(131, 67, 45);
+  CheckAllLevels<float>(37, 129, 29);
+  CheckAllLevels<int32_t>(53, 41, 33);
+  CheckAllLevels<int64_t>(41, 53, 19);
+  CheckAllLevels<long>(33, 34, 35);
+}
+
+TEST(TGemm, product_over_several_blocks_is_correct)
+{
+  const TGemmBlocking saved = gemm_blocking();
+  gemm_blocking() = { 13, 11, 17 };
+  CheckAllLevels<double>(61, 75, 40);
+  CheckAllLevels<int32_t>(29, 50, 47);
+  gemm_blocking() = saved;
+}
+
+TEST(TGemm, respects_leading_dimensions)
+{
+  // блок 40 x 40 из середины матриц 60 x 60
+  TDynamicMatrix<double> a(60), b(60);
+  for (size_t i = 0; i < 60; i++)
+    for (size_t j = 0; j < 60; j++)
+    {
+      a[i][j] = double(i + j % 5);
+      b[i][j] = double(int(i % 3) - int(j % 4));
+    }
+  TDynamicMatrix<double> res = a.block(10, 10, 40, 40) * b.block(5, 5, 40, 40);
+  for (size_t i = 0; i < 40; i++)
+    for (size_t j = 0; j < 40; j++)
+    {
+      double s = 0;
+      for (size_t p = 0; p < 40; p++)
+        s += a[10 + i][10 + p] * b[5 + p][5 + j];
+      EXPECT_EQ(s, res[i][j]);
+    }
+}
+
+TEST(TGemm, column_major_product_matches_row_major)
+{
+  TDynamicMatrix<double> a(45, 38), b(38, 51);
+  for (size_t i = 0; i < 45; i++)
+    for (size_t j = 0; j < 38; j++)
+      a[i][j] = double(int((i * 7 + j) % 9) - 4);
+  for (size_t i = 0; i < 38; i++)
+    for (size_t j = 0; j < 51; j++)
+      b[i][j] = double(int((i + j * 3) % 5) - 2);
+  TDynamicMatrix<double, TAlignedAllocator<double>, TColMajor> ca(a), cb(b);
+  TDynamicMatrix<double> res = a * b;
+  TDynamicMatrix<double, TAlignedAllocator<double>, TColMajor> cres = ca * cb;
+  for (size_t i = 0; i < 45; i++)
+    for (size_t j = 0; j < 51; j++)
+      EXPECT_EQ(res[i][j], cres.at(i, j));
+}
+
+template<typename T>
+static void CheckStrassen(size_t m, size_t n, size_t k, size_t crossover)
+{
+  const size_t saved = strassen_crossover();
+  strassen_crossover() = crossover;
+  vector<T> a(m * k), b(k * n), c(m * n, T(7)), expected(m * n);
+  for (size_t i = 0; i < a.size(); i++)
+    a[i] = T(int(i % 11) - 5);
+  for (size_t i = 0; i < b.size(); i++)
+    b[i] = T(int(i % 9) - 4);
+  for (size_t i = 0; i < m; i++)
+    for (size_t j = 0; j < n; j++)
+      for (size_t p = 0; p < k; p++)
+        expected[i * n + j] += a[i * k + p] * b[p * n + j];
+
+  strassen(m, n, k, a.data(), k, b.data(), n, c.data(), n);
+  EXPECT_EQ(expected, c);
+  strassen_crossover() = saved;
+}
+
+TEST(TGemm, strassen_below_crossover_is_correct)
+{
+  CheckStrassen<double>(20, 30, 40, 1024);
+}
+
+TEST(TGemm, strassen_with_even_sizes_is_correct)
+{
+  CheckStrassen<double>(64, 64, 64, 8);
+  CheckStrassen<int32_t>(48, 32, 80, 4);
+}
+
+TEST(TGemm, strassen_peels_odd_sizes)
+{
+  CheckStrassen<double>(37, 45, 29, 4);
+  CheckStrassen<int64_t>(51, 18, 77, 5);
+  CheckStrassen<long>(19, 23, 21, 2);
+}
+
+TEST(TGemm, strassen_product_of_matrices_matches_blocked)
+{
+  const size_t saved = strassen_crossover();
+  TDynamicMatrix<double> a(67, 70), b(70, 61), expected(67, 61);
+  for (size_t i = 0; i < 67; i++)
+    for (size_t j = 0; j < 70; j++)
+      a[i][j] = double(int((i * 5 + j) % 7) - 3);
+  for (size_t i = 0; i < 70; i++)
+    for (size_t j = 0; j < 61; j++)
+      b[i][j] = double(int((i + j * 2) % 5) - 2);
+  gemm(67, 61, 70, a.data(), 70, b.data(), 61, expected.data(), 61);
+  strassen_crossover() = 16;
+  TDynamicMatrix<double, TAlignedAllocator<double>, TColMajor> ca(a), cb(b);
+  EXPECT_EQ(expected, a * b);
+  EXPECT_EQ(expected, TDynamicMatrix<double>(ca * cb));
+  strassen_crossover() = saved;
+}
+
+template<typename T>
+static void CheckGemv(TSimdLevel level, size_t m, size_t n)
+{
+  set_simd_level(level);
+  vector<T> a(m * (n + 3)), x(n), xt(m), y(m), yt(n), expected(m), expected_t(n);
+  const size_t lda = n + 3;
+  for (size_t i = 0; i < a.size(); i++)
+    a[i] = T(int(i % 13) - 6);
+  for (size_t j = 0; j < n; j++)
+    x[j] = T(int(j % 5) - 2);
+  for (size_t i = 0; i < m; i++)
+    xt[i] = T(int(i % 7) - 3);
+  for (size_t i = 0; i < m; i++)
+    for (size_t j = 0; j < n; j++)
+    {
+      expected[i] += a[i * lda + j] * x[j];
+      expected_t[j] += xt[i] * a[i * lda + j];
+    }
+
+  gemv(m, n, a.data(), lda, x.data(), y.data());
+  EXPECT_EQ(expected, y);
+  gemv_t(m, n, a.data(), lda, xt.data(), yt.data());
+  EXPECT_EQ(expected_t, yt);
+  set_simd_level(simd_detect());
+}
+
+TEST(TGemm, gemv_is_correct)
+{
+  for (TSimdLevel level : { SIMD_NONE, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 })
+  {
+    CheckGemv<double>(level, 1, 1);
+    CheckGemv<double>(level, 23, 37);
+    CheckGemv<float>(level, 66, 45);
+    CheckGemv<int32_t>(level, 17, 70);
+    CheckGemv<int64_t>(level, 9, 31);
+    CheckGemv<long>(level, 10, 11);
+  }
+}
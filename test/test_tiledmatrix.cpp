@@ -0,0 +1,154 @@
+﻿#include "tiledmatrix.h"
+
+#include <cstdio>
+#include <gtest.h>
+
+static TDynamicMatrix<int> SampleMatrix(size_t r, size_t c)
+{
+  TDynamicMatrix<int> m(r, c);
+  for (size_t i = 0; i < r; i++)
+    for (size_t j = 0; j < c; j++)
+      m[i][j] = int(i * c + j) % 9 - 4;
+  return m;
+}
+
+TEST(TTiledMatrix, can_create_matrix_larger_than_max_matrix_size)
+{
+  {
+    TTiledMatrix<int> m("test_tiled_a.bin", MAX_MATRIX_SIZE * 2, 10, 10);
+
+    EXPECT_EQ(MAX_MATRIX_SIZE * 2, m.rows());
+    EXPECT_EQ(MAX_MATRIX_SIZE / 5, m.tile_rows());
+  }
+  remove("test_tiled_a.bin");
+}
+
+TEST(TTiledMatrix, throws_when_create_matrix_with_zero_tile)
+{
+  ASSERT_ANY_THROW(TTiledMatrix<int> m("test_tiled_a.bin", 10, 10, 0));
+  remove("test_tiled_a.bin");
+}
+
+TEST(TTiledMatrix, new_matrix_is_zero)
+{
+  {
+    TTiledMatrix<int> m("test_tiled_a.bin", 5, 3, 2);
+
+    EXPECT_EQ(TDynamicMatrix<int>(5, 3), m.dense());
+  }
+  remove("test_tiled_a.bin");
+}
+
+TEST(TTiledMatrix, can_store_and_reopen_matrix)
+{
+  TDynamicMatrix<int> d = SampleMatrix(5, 7);
+  {
+    TTiledMatrix<int> m("test_tiled_a.bin", 5, 7, 3);
+    m.assign(d);
+  }
+  {
+    TTiledMatrix<int> m("test_tiled_a.bin");
+
+    EXPECT_EQ(3u, m.tile());
+    EXPECT_EQ(d, m.dense());
+  }
+  remove("test_tiled_a.bin");
+}
+
+TEST(TTiledMatrix, out_of_core_product_matches_in_memory_product)
+{
+  TDynamicMatrix<int> da = SampleMatrix(7, 5), db = SampleMatrix(5, 8);
+  {
+    TTiledMatrix<int> a("test_tiled_a.bin", 7, 5, 2), b("test_tiled_b.bin", 5, 8, 2);
+    a.assign(da);
+    b.assign(db);
+    // 2 плитки + 4 полосы по 3 плитки: по одной строке и столбцу плиток
+    TTiledMatrix<int> c = a.multiply(b, "test_tiled_c.bin", (2 + 4 * 3) * 4 * sizeof(int));
+
+    EXPECT_EQ(da * db, c.dense());
+  }
+  remove("test_tiled_a.bin");
+  remove("test_tiled_b.bin");
+  remove("test_tiled_c.bin");
+}
+
+TEST(TTiledMatrix, product_does_not_depend_on_resident_panels)
+{
+  TDynamicMatrix<int> da = SampleMatrix(7, 5), db = SampleMatrix(5, 8);
+  {
+    TTiledMatrix<int> a("test_tiled_a.bin", 7, 5, 2), b("test_tiled_b.bin", 5, 8, 2);
+    a.assign(da);
+    b.assign(db);
+    // по паре буферов на 3, 5 и 8 полос
+    for (size_t panels : { 3u, 5u, 8u })
+    {
+      TTiledMatrix<int> c = a.multiply(b, "test_tiled_c.bin", (2 + 2 * panels * 3) * 4 * sizeof(int));
+
+      EXPECT_EQ(da * db, c.dense());
+    }
+  }
+  remove("test_tiled_a.bin");
+  remove("test_tiled_b.bin");
+  remove("test_tiled_c.bin");
+}
+
+TEST(TTiledMatrix, out_of_core_product_with_large_tiles_matches_in_memory_product)
+{
+  TDynamicMatrix<double> da(90, 70), db(70, 50);
+  for (size_t i = 0; i < 90; i++)
+    for (size_t j = 0; j < 70; j++)
+      da[i][j] = double(int(i + 3 * j) % 7 - 3);
+  for (size_t i = 0; i < 70; i++)
+    for (size_t j = 0; j < 50; j++)
+      db[i][j] = double(int(2 * i + j) % 5 - 2);
+  {
+    TTiledMatrix<double> a("test_tiled_a.bin", 90, 70, 40), b("test_tiled_b.bin", 70, 50, 40);
+    a.assign(da);
+    b.assign(db);
+    TTiledMatrix<double> c = a.multiply(b, "test_tiled_c.bin", 1 << 20);
+
+    EXPECT_EQ(da * db, c.dense());
+  }
+  remove("test_tiled_a.bin");
+  remove("test_tiled_b.bin");
+  remove("test_tiled_c.bin");
+}
+
+TEST(TTiledMatrix, throws_when_budget_is_too_small)
+{
+  {
+    TTiledMatrix<int> a("test_tiled_a.bin", 4, 4, 2);
+
+    // 2 плитки + 4 полосы по 2 плитки
+    ASSERT_ANY_THROW(a.multiply(a, "test_tiled_c.bin", 5 * 4 * sizeof(int)));
+    ASSERT_ANY_THROW(a.multiply(a, "test_tiled_c.bin", 10 * 4 * sizeof(int) - 1));
+    ASSERT_NO_THROW(a.multiply(a, "test_tiled_c.bin", 10 * 4 * sizeof(int)));
+  }
+  remove("test_tiled_a.bin");
+  remove("test_tiled_c.bin");
+}
+
+TEST(TTiledMatrix, budget_counts_gemm_packing_buffers)
+{
+  {
+    TTiledMatrix<double> a("test_tiled_a.bin", 64, 64, 64);
+    const size_t buffers = 2 * 64 * 64 + 4 * 64 * 64;
+
+    EXPECT_LT(0u, gemm_workspace<double>(64, 64, 64));
+    ASSERT_ANY_THROW(a.multiply(a, "test_tiled_c.bin", buffers * sizeof(double)));
+    ASSERT_NO_THROW(a.multiply(a, "test_tiled_c.bin", (buffers + gemm_workspace<double>(64, 64, 64)) * sizeof(double)));
+  }
+  remove("test_tiled_a.bin");
+  remove("test_tiled_c.bin");
+}
+
+TEST(TTiledMatrix, throws_when_multiply_matrices_with_incompatible_sizes)
+{
+  {
+    TTiledMatrix<int> a("test_tiled_a.bin", 4, 3, 2);
+
+    ASSERT_ANY_THROW(a.multiply(a, "test_tiled_c.bin", 1 << 20));
+  }
+  remove("test_tiled_a.bin");
+  remove("test_tiled_c.bin");
+}
@@ -26,86 +26,353 @@ TEST(TDynamicMatrix, can_create_copied_matrix)
 
 TEST(TDynamicMatrix, copied_matrix_is_equal_to_source_one)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(3);
+  m[1][2] = 4;
+  TDynamicMatrix<int> m1(m);
+
+  EXPECT_EQ(m, m1);
 }
 
 TEST(TDynamicMatrix, copied_matrix_has_its_own_memory)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(3);
+  TDynamicMatrix<int> m1(m);
+  m1[1][2] = 4;
+
+  EXPECT_EQ(0, m[1][2]);
+  EXPECT_NE(&m[0][0], &m1[0][0]);
 }
 
 TEST(TDynamicMatrix, can_get_size)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(4);
+
+  EXPECT_EQ(4u, m.size());
 }
 
 TEST(TDynamicMatrix, can_set_and_get_element)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(4);
+  m[2][3] = 5;
+
+  EXPECT_EQ(5, m[2][3]);
+  EXPECT_EQ(5, m.at(2, 3));
 }
 
 TEST(TDynamicMatrix, throws_when_set_element_with_negative_index)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(4);
+
+  ASSERT_ANY_THROW(m.at(-1, 0) = 1);
 }
 
 TEST(TDynamicMatrix, throws_when_set_element_with_too_large_index)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(4);
+
+  ASSERT_ANY_THROW(m.at(0, 4) = 1);
 }
 
 TEST(TDynamicMatrix, can_assign_matrix_to_itself)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(3);
+  m[1][1] = 7;
+  m = m;
+
+  EXPECT_EQ(7, m[1][1]);
 }
 
 TEST(TDynamicMatrix, can_assign_matrices_of_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(3), m1(3);
+  m[2][0] = 3;
+  m1 = m;
+
+  EXPECT_EQ(m, m1);
 }
 
 TEST(TDynamicMatrix, assign_operator_change_matrix_size)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(4), m1(2);
+  m1 = m;
+
+  EXPECT_EQ(4u, m1.size());
 }
 
 TEST(TDynamicMatrix, can_assign_matrices_of_different_size)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(4), m1(2);
+  m[3][3] = 9;
+  m1 = m;
+
+  EXPECT_EQ(m, m1);
+}
+
+TEST(TDynamicMatrix, moved_from_matrix_is_empty)
+{
+  TDynamicMatrix<int> m(3), m1(2);
+  m[2][2] = 5;
+  TDynamicMatrix<int> m2(std::move(m));
+
+  EXPECT_EQ(0u, m.rows());
+  EXPECT_EQ(0u, m.cols());
+  EXPECT_EQ(5, m2[2][2]);
+
+  m1 = std::move(m2);
+  EXPECT_EQ(0u, m2.rows());
+  EXPECT_EQ(0u, m2.cols());
+  EXPECT_EQ(3u, m1.rows());
+  EXPECT_EQ(5, m1[2][2]);
 }
 
 TEST(TDynamicMatrix, compare_equal_matrices_return_true)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(3), m1(3);
+  m[0][1] = m1[0][1] = 2;
+
+  EXPECT_TRUE(m == m1);
 }
 
 TEST(TDynamicMatrix, compare_matrix_with_itself_return_true)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(3);
+
+  EXPECT_TRUE(m == m);
 }
 
 TEST(TDynamicMatrix, matrices_with_different_size_are_not_equal)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(3), m1(4);
+
+  EXPECT_NE(m, m1);
 }
 
 TEST(TDynamicMatrix, can_add_matrices_with_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(2), m1(2);
+  m[0][0] = 1; m1[0][0] = 2; m1[1][1] = 5;
+  TDynamicMatrix<int> res = m + m1;
+
+  EXPECT_EQ(3, res[0][0]);
+  EXPECT_EQ(5, res[1][1]);
 }
 
 TEST(TDynamicMatrix, cant_add_matrices_with_not_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(3), m1(4);
+
+  ASSERT_ANY_THROW(m + m1);
 }
 
 TEST(TDynamicMatrix, can_subtract_matrices_with_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(2), m1(2);
+  m[0][0] = 1; m1[0][0] = 2; m1[1][1] = 5;
+  TDynamicMatrix<int> res = m - m1;
+
+  EXPECT_EQ(-1, res[0][0]);
+  EXPECT_EQ(-5, res[1][1]);
 }
 
 TEST(TDynamicMatrix, cant_subtract_matrixes_with_not_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicMatrix<int> m(3), m1(4);
+
+  ASSERT_ANY_THROW(m - m1);
+}
+
+TEST(TDynamicMatrix, rows_are_stored_contiguously)
+{
+  TDynamicMatrix<int> m(3);
+
+  EXPECT_EQ(&m[0][0] + 3, &m[1][0]);
+  EXPECT_EQ(&m[0][0] + 8, &m[2][2]);
+}
+
+TEST(TDynamicMatrix, can_multiply_matrix_by_scalar)
+{
+  TDynamicMatrix<int> m(2);
+  m[0][1] = 2; m[1][0] = 3;
+  TDynamicMatrix<int> res = m * 2;
+
+  EXPECT_EQ(4, res[0][1]);
+  EXPECT_EQ(6, res[1][0]);
+}
+
+TEST(TDynamicMatrix, can_multiply_matrix_by_vector)
+{
+  TDynamicMatrix<int> m(2);
+  m[0][0] = 1; m[0][1] = 2;
+  m[1][0] = 3; m[1][1] = 4;
+  TDynamicVector<int> v(2);
+  v[0] = 5; v[1] = 6;
+  TDynamicVector<int> res = m * v;
+
+  EXPECT_EQ(17, res[0]);
+  EXPECT_EQ(39, res[1]);
+}
+
+TEST(TDynamicMatrix, can_multiply_matrices_with_equal_size)
+{
+  TDynamicMatrix<int> m(2), m1(2);
+  m[0][0] = 1; m[0][1] = 2;
+  m[1][0] = 3; m[1][1] = 4;
+  m1[0][0] = 5; m1[0][1] = 6;
+  m1[1][0] = 7; m1[1][1] = 8;
+  TDynamicMatrix<int> res = m * m1;
+
+  EXPECT_EQ(19, res[0][0]);
+  EXPECT_EQ(22, res[0][1]);
+  EXPECT_EQ(43, res[1][0]);
+  EXPECT_EQ(50, res[1][1]);
+}
+
+TEST(TDynamicMatrix, cant_multiply_matrices_with_not_equal_size)
+{
+  TDynamicMatrix<int> m(3), m1(4);
+
+  ASSERT_ANY_THROW(m * m1);
+}
+
+TEST(TDynamicMatrix, can_create_tall_rectangular_matrix)
+{
+  TDynamicMatrix<double> m(1000000, 20);
+
+  EXPECT_EQ(1000000u, m.rows());
+  EXPECT_EQ(20u, m.cols());
+}
+
+TEST(TDynamicMatrix, cant_create_matrix_with_too_many_elements)
+{
+  ASSERT_ANY_THROW(TDynamicMatrix<int> m(MAX_MATRIX_ELEMENTS, 2));
+  ASSERT_ANY_THROW(TDynamicMatrix<int> m(size_t(1) << 40, size_t(1) << 40));
+}
+
+TEST(TDynamicMatrix, throws_when_set_element_outside_rectangular_matrix)
+{
+  TDynamicMatrix<int> m(2, 5);
+
+  ASSERT_NO_THROW(m.at(1, 4) = 1);
+  ASSERT_ANY_THROW(m.at(2, 0) = 1);
+}
+
+TEST(TDynamicMatrix, matrices_with_transposed_shapes_are_not_equal)
+{
+  TDynamicMatrix<int> m(2, 3), m1(3, 2);
+
+  EXPECT_NE(m, m1);
+}
+
+TEST(TDynamicMatrix, can_multiply_rectangular_matrix_by_vector)
+{
+  TDynamicMatrix<int> m(2, 3);
+  m[0][0] = 1; m[0][1] = 2; m[0][2] = 3;
+  m[1][0] = 4; m[1][1] = 5; m[1][2] = 6;
+  TDynamicVector<int> v(3);
+  v[0] = 1; v[1] = 1; v[2] = 1;
+  TDynamicVector<int> res = m * v;
+
+  EXPECT_EQ(2u, res.size());
+  EXPECT_EQ(6, res[0]);
+  EXPECT_EQ(15, res[1]);
+}
+
+TEST(TDynamicMatrix, can_multiply_matrices_with_compatible_shapes)
+{
+  TDynamicMatrix<int> m(2, 3), m1(3, 1);
+  m[0][0] = 1; m[0][1] = 2; m[0][2] = 3;
+  m[1][0] = 4; m[1][1] = 5; m[1][2] = 6;
+  m1[0][0] = 1; m1[1][0] = 2; m1[2][0] = 3;
+  TDynamicMatrix<int> res = m * m1;
+
+  EXPECT_EQ(2u, res.rows());
+  EXPECT_EQ(1u, res.cols());
+  EXPECT_EQ(14, res[0][0]);
+  EXPECT_EQ(32, res[1][0]);
+}
+
+TEST(TDynamicMatrix, cant_multiply_matrices_with_incompatible_shapes)
+{
+  TDynamicMatrix<int> m(2, 3), m1(2, 3);
+
+  ASSERT_ANY_THROW(m * m1);
+}
+
+TEST(TDynamicMatrix, can_adopt_row_major_buffer)
+{
+  int* p = new int[6]();
+  p[4] = 7;
+  TDynamicMatrix<int> m(p, 2, 3, ADOPT);
+
+  EXPECT_EQ(7, m[1][1]);
+  pair<int*, size_t> r = m.release();
+  EXPECT_EQ(p, r.first);
+  EXPECT_EQ(6u, r.second);
+  EXPECT_EQ(0u, m.rows());
+  delete[] p;
+}
+
+
+
+TEST(TDynamicMatrix, column_major_matrix_stores_columns_contiguously)
+{
+  TDynamicMatrix<int, TAlignedAllocator<int>, TColMajor> m(2, 3);
+  m[0][1] = 5;
+  m.at(1, 2) = 7;
+
+  EXPECT_EQ(5, m.data()[2]);
+  EXPECT_EQ(7, m.data()[5]);
+  EXPECT_EQ(1u, m.col(2).stride());
+  EXPECT_EQ(2u, m.row(0).stride());
 }
 
+TEST(TDynamicMatrix, can_convert_between_layouts)
+{
+  TDynamicMatrix<int> m(2, 3);
+  m[0][2] = 3; m[1][0] = 4;
+  TDynamicMatrix<int, TAlignedAllocator<int>, TColMajor> cm(m);
+
+  EXPECT_EQ(3, cm[0][2]);
+  EXPECT_EQ(4, cm.at(1, 0));
+  EXPECT_EQ(m, TDynamicMatrix<int>(cm));
+}
+
+TEST(TDynamicMatrix, column_major_products_match_row_major)
+{
+  TDynamicMatrix<int> a(3, 4), b(4, 2);
+  for (size_t i = 0; i < 3; i++)
+    for (size_t j = 0; j < 4; j++)
+      a[i][j] = int(i * 4 + j) - 5;
+  for (size_t i = 0; i < 4; i++)
+    for (size_t j = 0; j < 2; j++)
+      b[i][j] = int(i + j * 3) - 2;
+  TDynamicVector<int> v(4);
+  v[0] = 1; v[1] = -2; v[3] = 3;
+  using TColMatrix = TDynamicMatrix<int, TAlignedAllocator<int>, TColMajor>;
+  TColMatrix ca(a), cb(b);
+
+  EXPECT_EQ(a * v, ca * v);
+  EXPECT_EQ(a * v, ca * v.slice(0, 4));
+  EXPECT_EQ(a * b, TDynamicMatrix<int>(ca * cb));
+}
+
+TEST(TDynamicMatrix, can_multiply_vector_by_matrix)
+{
+  TDynamicMatrix<int> m(3, 2);
+  m[0][0] = 1; m[0][1] = 2;
+  m[1][0] = 3; m[1][1] = 4;
+  m[2][0] = 5; m[2][1] = 6;
+  TDynamicVector<int> v(3), expected(2);
+  v[0] = 1; v[1] = 0; v[2] = -1;
+  expected[0] = -4; expected[1] = -4;
+  EXPECT_EQ(expected, v * m);
+  TDynamicMatrix<int, TAlignedAllocator<int>, TColMajor> cm(m);
+  EXPECT_EQ(expected, v * cm);
+}
+
+TEST(TDynamicMatrix, cant_multiply_vector_by_matrix_with_not_equal_size)
+{
+  TDynamicMatrix<int> m(3, 2);
+  TDynamicVector<int> v(2);
+  ASSERT_ANY_THROW(v * m);
+}
@@ -0,0 +1,84 @@
+#include "tnuma.h"
+
+#include <atomic>
+#include <cerrno>
+#include <gtest.h>
+
+// move_pages не поддерживается ядром (песочница) - проверять нечего
+static bool PageNodesUnsupported(const vector<int>& nodes)
+{
+  return !nodes.empty() && nodes[0] == -ENOSYS;
+}
+
+TEST(TNuma, row_ranges_cover_all_rows)
+{
+  size_t next = 0;
+  for (size_t t = 0; t < 4; t++)
+  {
+    pair<size_t, size_t> r = row_range(10, t, 4);
+
+    EXPECT_EQ(next, r.first);
+    EXPECT_LE(r.second - r.first, 3u);
+    next = r.second;
+  }
+  EXPECT_EQ(10u, next);
+}
+
+TEST(TNuma, parallel_rows_visits_each_row_once)
+{
+  vector<atomic<int>> visits(37);
+  parallel_rows(visits.size(), 4, [&visits](size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; i++)
+      visits[i]++;
+  });
+
+  for (size_t i = 0; i < visits.size(); i++)
+    EXPECT_EQ(1, visits[i]);
+}
+
+TEST(TNuma, first_touch_initializes_matrix)
+{
+  TDynamicMatrix<double> m(300, 200, NO_INIT);
+  first_touch(m, 3);
+
+  EXPECT_EQ(TDynamicMatrix<double>(300, 200), m);
+}
+
+TEST(TNuma, page_nodes_reports_touched_pages)
+{
+  TDynamicMatrix<double> m(300, 200);
+  const size_t bytes = m.rows() * m.cols() * sizeof(double);
+  vector<int> nodes = page_nodes(m.data(), bytes);
+  if (PageNodesUnsupported(nodes))
+    return;
+
+#ifdef __linux__
+  EXPECT_GE(nodes.size(), bytes / 4096);
+#endif
+  for (int node : nodes)
+    EXPECT_LE(0, node);
+}
+
+TEST(TNuma, interleaved_pages_are_placed_on_touch)
+{
+  const size_t n = HUGE_PAGE_SIZE / sizeof(double) * 2, bytes = n * sizeof(double);
+  TDynamicVector<double, THugePageAllocator<double>> v(n, NO_INIT);
+#if defined(__linux__) && defined(SYS_mbind)
+  errno = 0;
+  const bool interleaved = interleave_pages(v.data(), bytes);
+  if (!interleaved && errno == ENOSYS)
+    return;
+  ASSERT_TRUE(interleaved);
+#else
+  EXPECT_FALSE(interleave_pages(v.data(), bytes));
+#endif
+
+  for (size_t i = 0; i < n; i++)
+    v[i] = double(i);
+  vector<int> nodes = page_nodes(v.data(), bytes);
+  if (PageNodesUnsupported(nodes))
+    return;
+  for (int node : nodes)
+    EXPECT_LE(0, node);
+}
@@ -0,0 +1,96 @@
+﻿#include "tmatrix.h"
+
+#include <gtest.h>
+
+#include <cmath>
+#include <vector>
+
+template<typename T>
+static void CheckKernels(TSimdLevel level)
+{
+  set_simd_level(level);
+  for (size_t n = 1; n < 80; n += 7)
+  {
+    T a[80], b[80], r[80];
+    for (size_t i = 0; i < n; i++)
+    {
+      a[i] = T(int(i % 11) - 5);
+      b[i] = T(int(i % 7) - 2);
+    }
+    T dot = T();
+    for (size_t i = 0; i < n; i++)
+      dot += a[i] * b[i];
+
+    simd_add(a, b, r, n);
+    for (size_t i = 0; i < n; i++)
+      EXPECT_EQ(a[i] + b[i], r[i]);
+    simd_sub(a, b, r, n);
+    for (size_t i = 0; i < n; i++)
+      EXPECT_EQ(a[i] - b[i], r[i]);
+    EXPECT_EQ(dot, simd_dot(a, b, n));
+  }
+  set_simd_level(simd_detect());
+}
+
+TEST(TSimd, level_does_not_exceed_detected)
+{
+  EXPECT_LE(simd_level(), simd_detect());
+  set_simd_level(SIMD_AVX512);
+  EXPECT_EQ(simd_detect(), simd_level());
+}
+
+TEST(TSimd, kernels_match_scalar_loops_on_every_level)
+{
+  for (int level = SIMD_NONE; level <= simd_detect(); level++)
+  {
+    CheckKernels<float>(TSimdLevel(level));
+    CheckKernels<double>(TSimdLevel(level));
+    CheckKernels<int32_t>(TSimdLevel(level));
+    CheckKernels<int64_t>(TSimdLevel(level));
+  }
+}
+
+#ifdef MP2_SIMD_X86
+template<typename V>
+static double FusedDot()
+{
+  // a0 * b0 = 1 + 2^-29 + 2^-60 округляется до 1 + 2^-29; следующее слагаемое
+  // той же дорожки без округления произведения дает -2^-60, иначе - 0
+  const size_t n = 8 * V::width;
+  vector<double> a(n), b(n);
+  a[0] = b[0] = a[4 * V::width] = 1 + ldexp(1.0, -30);
+  b[4 * V::width] = -a[0];
+  return simd_dot(a.data(), b.data(), n);
+}
+
+TEST(TSimd, dot_uses_fused_multiply_add_from_avx2)
+{
+  if (simd_detect() >= SIMD_AVX2)
+  {
+    set_simd_level(SIMD_AVX2);
+    EXPECT_EQ(-ldexp(1.0, -60), FusedDot<TAvx2<double>>());
+  }
+  if (simd_detect() >= SIMD_AVX512)
+  {
+    set_simd_level(SIMD_AVX512);
+    EXPECT_EQ(-ldexp(1.0, -60), FusedDot<TAvx512<double>>());
+  }
+  set_simd_level(SIMD_SSE2);
+  EXPECT_EQ(0, FusedDot<TSse2<double>>());
+  set_simd_level(simd_detect());
+}
+#endif
+
+TEST(TSimd, vector_operations_use_kernels_for_any_size)
+{
+  TDynamicVector<double> v(37), v1(37);
+  for (size_t i = 0; i < 37; i++)
+  {
+    v[i] = double(i);
+    v1[i] = 1;
+  }
+
+  EXPECT_EQ(36 * 37 / 2, v * v1);
+  EXPECT_EQ(37, (v + v1 * 2)[35]);
+  EXPECT_EQ(34, (v - v1)[35]);
+}
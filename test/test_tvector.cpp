@@ -1,7 +1,47 @@
-#include "tmatrix.h"
+﻿#include "tmatrix.h"
 
 #include <gtest.h>
 
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// аллокатор, подсчитывающий число живых выделений
+template<typename T>
+struct TCountingAllocator
+{
+  using value_type = T;
+  static int live;
+
+  TCountingAllocator() noexcept {}
+  template<typename U>
+  TCountingAllocator(const TCountingAllocator<U>&) noexcept {}
+
+  T* allocate(size_t n) { live++; return std::allocator<T>().allocate(n); }
+  void deallocate(T* p, size_t n) noexcept { live--; std::allocator<T>().deallocate(p, n); }
+
+  bool operator==(const TCountingAllocator&) const noexcept { return true; }
+  bool operator!=(const TCountingAllocator&) const noexcept { return false; }
+};
+template<typename T>
+int TCountingAllocator<T>::live = 0;
+
+// элемент, копирование которого выбрасывает исключение по запросу
+struct TThrowingCopy
+{
+  static bool fail;
+  int val = 0;
+
+  TThrowingCopy() {}
+  TThrowingCopy(const TThrowingCopy& t) : val(t.val)
+  {
+    if (fail)
+      throw runtime_error("Copy failed");
+  }
+  TThrowingCopy& operator=(const TThrowingCopy&) = default;
+};
+bool TThrowingCopy::fail = false;
+
 TEST(TDynamicVector, can_create_vector_with_positive_length)
 {
   ASSERT_NO_THROW(TDynamicVector<int> v(5));
@@ -26,116 +66,426 @@ TEST(TDynamicVector, can_create_copied_vector)
 
 TEST(TDynamicVector, copied_vector_is_equal_to_source_one)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3);
+  v[0] = 1; v[1] = 2; v[2] = 3;
+  TDynamicVector<int> v1(v);
+
+  EXPECT_EQ(v, v1);
 }
 
 TEST(TDynamicVector, copied_vector_has_its_own_memory)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3);
+  TDynamicVector<int> v1(v);
+  v1[0] = 5;
+
+  EXPECT_EQ(0, v[0]);
+  EXPECT_NE(&v[0], &v1[0]);
 }
 
 TEST(TDynamicVector, can_get_size)
 {
   TDynamicVector<int> v(4);
 
-  EXPECT_EQ(4, v.size());
+  EXPECT_EQ(4u, v.size());
 }
 
-//TEST(TDynamicVector, can_set_and_get_element)
-//{
-//  TDynamicVector<int> v(4);
-//  v[0] = 4;
-//
-//  EXPECT_EQ(4, v[0]);
-//}
+TEST(TDynamicVector, can_set_and_get_element)
+{
+  TDynamicVector<int> v(4);
+  v[0] = 4;
+
+  EXPECT_EQ(4, v[0]);
+}
 
 TEST(TDynamicVector, throws_when_set_element_with_negative_index)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(4);
+
+  ASSERT_ANY_THROW(v.at(-1) = 1);
 }
 
 TEST(TDynamicVector, throws_when_set_element_with_too_large_index)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(4);
+
+  ASSERT_ANY_THROW(v.at(4) = 1);
 }
 
 TEST(TDynamicVector, can_assign_vector_to_itself)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(4);
+  v[1] = 7;
+  v = v;
+
+  EXPECT_EQ(7, v[1]);
 }
 
 TEST(TDynamicVector, can_assign_vectors_of_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(4), v1(4);
+  v[2] = 3;
+  v1 = v;
+
+  EXPECT_EQ(v, v1);
 }
 
 TEST(TDynamicVector, assign_operator_change_vector_size)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(4), v1(2);
+  v1 = v;
+
+  EXPECT_EQ(4u, v1.size());
 }
 
 TEST(TDynamicVector, can_assign_vectors_of_different_size)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(4), v1(2);
+  v[3] = 9;
+  v1 = v;
+
+  EXPECT_EQ(v, v1);
 }
 
 TEST(TDynamicVector, compare_equal_vectors_return_true)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3), v1(3);
+  v[0] = v1[0] = 2;
+
+  EXPECT_TRUE(v == v1);
 }
 
 TEST(TDynamicVector, compare_vector_with_itself_return_true)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3);
+
+  EXPECT_TRUE(v == v);
 }
 
 TEST(TDynamicVector, vectors_with_different_size_are_not_equal)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3), v1(4);
+
+  EXPECT_NE(v, v1);
 }
 
 TEST(TDynamicVector, can_add_scalar_to_vector)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3);
+  v[0] = 1;
+  TDynamicVector<int> res = v + 2;
+
+  EXPECT_EQ(3, res[0]);
+  EXPECT_EQ(2, res[2]);
 }
 
 TEST(TDynamicVector, can_subtract_scalar_from_vector)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3);
+  v[0] = 1;
+  TDynamicVector<int> res = v - 2;
+
+  EXPECT_EQ(-1, res[0]);
+  EXPECT_EQ(-2, res[2]);
 }
 
 TEST(TDynamicVector, can_multiply_scalar_by_vector)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3);
+  v[0] = 1; v[1] = 2; v[2] = 3;
+  TDynamicVector<int> res = v * 3;
+
+  EXPECT_EQ(3, res[0]);
+  EXPECT_EQ(9, res[2]);
 }
 
 TEST(TDynamicVector, can_add_vectors_with_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3), v1(3);
+  v[0] = 1; v1[0] = 2; v1[2] = 5;
+  TDynamicVector<int> res = v + v1;
+
+  EXPECT_EQ(3, res[0]);
+  EXPECT_EQ(5, res[2]);
 }
 
 TEST(TDynamicVector, cant_add_vectors_with_not_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3), v1(4);
+
+  ASSERT_ANY_THROW(v + v1);
 }
 
 TEST(TDynamicVector, can_subtract_vectors_with_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3), v1(3);
+  v[0] = 1; v1[0] = 2; v1[2] = 5;
+  TDynamicVector<int> res = v - v1;
+
+  EXPECT_EQ(-1, res[0]);
+  EXPECT_EQ(-5, res[2]);
 }
 
 TEST(TDynamicVector, cant_subtract_vectors_with_not_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3), v1(4);
+
+  ASSERT_ANY_THROW(v - v1);
 }
 
 TEST(TDynamicVector, can_multiply_vectors_with_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3), v1(3);
+  v[0] = 1; v[1] = 2; v[2] = 3;
+  v1[0] = 4; v1[1] = 5; v1[2] = 6;
+
+  EXPECT_EQ(32, v * v1);
 }
 
 TEST(TDynamicVector, cant_multiply_vectors_with_not_equal_size)
 {
-  ADD_FAILURE();
+  TDynamicVector<int> v(3), v1(4);
+
+  ASSERT_ANY_THROW(v * v1);
 }
 
+TEST(TDynamicVector, memory_is_aligned_to_cache_line_by_default)
+{
+  TDynamicVector<char> v(300);
+  TDynamicVector<double> v1(70);
+
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(&v[0]) % DEFAULT_ALIGNMENT);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(&v1[0]) % DEFAULT_ALIGNMENT);
+}
+
+TEST(TDynamicVector, inline_buffer_is_aligned_to_cache_line)
+{
+  TDynamicVector<char> v(3);
+  TDynamicVector<double> v1(SMALL_VECTOR_BYTES / sizeof(double));
+
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(v.data()) % DEFAULT_ALIGNMENT);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(v1.data()) % DEFAULT_ALIGNMENT);
+}
+
+TEST(TDynamicVector, can_use_custom_allocator)
+{
+  {
+    TDynamicVector<int, TCountingAllocator<int>> v(100), v1(v);
+    v1[0] = 3;
+    v = v1 + v;
+
+    EXPECT_EQ(3, v[0]);
+    EXPECT_EQ(2, TCountingAllocator<int>::live);
+  }
+  EXPECT_EQ(0, TCountingAllocator<int>::live);
+}
+
+TEST(TDynamicVector, can_use_huge_page_allocator)
+{
+  const size_t n = HUGE_PAGE_SIZE / sizeof(double) * 2;
+  TDynamicVector<double, THugePageAllocator<double>> v(n), v1(n);
+  v[n - 1] = 2;
+  v1 = v + v;
+
+  EXPECT_EQ(4, v1[n - 1]);
+#ifdef __linux__
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(v.data()) % HUGE_PAGE_SIZE);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(v1.data()) % HUGE_PAGE_SIZE);
+
+  // большие страницы обязательны, если THP не запрещены ("[never]")
+  ifstream thp("/sys/kernel/mm/transparent_hugepage/enabled");
+  string mode;
+  getline(thp, mode);
+  if (mode.find("[always]") == string::npos && mode.find("[madvise]") == string::npos)
+    return;
+  EXPECT_NE(PAGES_DEFAULT, page_backing(v.data()));
+  EXPECT_NE(PAGES_DEFAULT, page_backing(v1.data()));
+#else
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(v.data()) % THugePageAllocator<double>::alignment);
+  EXPECT_EQ(PAGES_DEFAULT, page_backing(v.data()));
+#endif
+}
+
+TEST(TDynamicVector, small_buffer_of_huge_page_allocator_uses_default_pages)
+{
+  THugePageAllocator<char, HUGE_PAGE_SIZE> a;
+  char* p = a.allocate(1000);
+
+  EXPECT_NE(PAGES_HUGETLB, page_backing(p));
+  a.deallocate(p, 1000);
+}
+
+TEST(TDynamicVector, can_store_vectors)
+{
+  TDynamicVector<TDynamicVector<int>> v(3);
+  v[1] = TDynamicVector<int>(4);
+  v[1][3] = 2;
+  TDynamicVector<TDynamicVector<int>> v1(v);
+
+  EXPECT_EQ(4u, v1[1].size());
+  EXPECT_EQ(2, v1[1][3]);
+}
+
+TEST(TDynamicVector, short_vector_does_not_allocate)
+{
+  {
+    TDynamicVector<int, TCountingAllocator<int>, 4> v(4), v1(v);
+    v = v + v1;
+
+    EXPECT_EQ(0, TCountingAllocator<int>::live);
+  }
+  TDynamicVector<int, TCountingAllocator<int>, 4> v(5);
+  EXPECT_EQ(1, TCountingAllocator<int>::live);
+}
+
+TEST(TDynamicVector, failed_assignment_to_short_vector_keeps_it_intact)
+{
+  TDynamicVector<TThrowingCopy, TAlignedAllocator<TThrowingCopy>, 4> v(3), v1(2);
+  v[2].val = 5;
+  TThrowingCopy::fail = true;
+  ASSERT_ANY_THROW(v = v1);
+  TThrowingCopy::fail = false;
+
+  EXPECT_EQ(3u, v.size());
+  EXPECT_EQ(5, v[2].val);
+}
+
+TEST(TDynamicVector, can_move_short_vector)
+{
+  TDynamicVector<int> v(3);
+  v[2] = 5;
+  TDynamicVector<int> v1(std::move(v));
+
+  EXPECT_EQ(3u, v1.size());
+  EXPECT_EQ(5, v1[2]);
+}
+
+TEST(TDynamicVector, can_swap_short_and_long_vectors)
+{
+  TDynamicVector<int> v(3), v1(1000);
+  v[2] = 5;
+  v1[999] = 7;
+  swap(v, v1);
+
+  EXPECT_EQ(1000u, v.size());
+  EXPECT_EQ(7, v[999]);
+  EXPECT_EQ(3u, v1.size());
+  EXPECT_EQ(5, v1[2]);
+}
+
+TEST(TDynamicVector, can_swap_short_vectors_of_different_size)
+{
+  TDynamicVector<TDynamicVector<int>, TAlignedAllocator<TDynamicVector<int>>, 2> v(1), v1(2);
+  v[0] = TDynamicVector<int>(5);
+  v1[1] = TDynamicVector<int>(7);
+  swap(v, v1);
+
+  EXPECT_EQ(2u, v.size());
+  EXPECT_EQ(7u, v[1].size());
+  EXPECT_EQ(1u, v1.size());
+  EXPECT_EQ(5u, v1[0].size());
+}
+
+TEST(TDynamicVector, can_assign_long_vector_to_short_one)
+{
+  TDynamicVector<int> v(3), v1(1000);
+  v1[999] = 7;
+  v = v1;
+  v1 = TDynamicVector<int>(2);
+
+  EXPECT_EQ(7, v[999]);
+  EXPECT_EQ(2u, v1.size());
+}
+
+TEST(TDynamicVector, can_create_uninitialized_vector)
+{
+  TDynamicVector<int> v(1000, NO_INIT);
+
+  EXPECT_EQ(1000u, v.size());
+  ASSERT_ANY_THROW(TDynamicVector<int> v1(0, NO_INIT));
+}
+
+TEST(TDynamicVector, uninitialized_vector_default_constructs_class_elements)
+{
+  TDynamicVector<TDynamicVector<int>> v(3, NO_INIT);
+
+  EXPECT_EQ(1u, v[2].size());
+  EXPECT_EQ(0, v[2][0]);
+}
+
+TEST(TDynamicVector, can_adopt_buffer_without_copy)
+{
+  int* p = new int[100]();
+  p[5] = 3;
+  TDynamicVector<int> v(p, 100, ADOPT);
+
+  EXPECT_EQ(p, v.data());
+  EXPECT_EQ(3, v[5]);
+}
+
+TEST(TDynamicVector, calls_custom_deleter_for_adopted_buffer)
+{
+  int buf[100] = {};
+  int calls = 0;
+  {
+    TDynamicVector<int> v(buf, 100, ADOPT, [&calls](int*) { calls++; });
+    TDynamicVector<int> v1(std::move(v));
+    v1[0] = 1;
+
+    EXPECT_EQ(0, calls);
+    EXPECT_EQ(1, buf[0]);
+  }
+  EXPECT_EQ(1, calls);
+}
+
+TEST(TDynamicVector, release_hands_adopted_buffer_back)
+{
+  int buf[100] = {};
+  int calls = 0;
+  TDynamicVector<int> v(buf, 100, ADOPT, [&calls](int*) { calls++; });
+  pair<int*, size_t> p = v.release();
+
+  EXPECT_EQ(buf, p.first);
+  EXPECT_EQ(100u, p.second);
+  EXPECT_EQ(0u, v.size());
+  EXPECT_EQ(0, calls);
+}
+
+TEST(TDynamicVector, can_release_own_buffer)
+{
+  TDynamicVector<int> v(100);
+  v[99] = 4;
+  pair<int*, size_t> p = v.release();
+
+  EXPECT_EQ(4, p.first[99]);
+  EXPECT_EQ(100u, p.second);
+  v.get_allocator().deallocate(p.first, p.second);
+}
+
+TEST(TDynamicVector, released_buffer_is_freed_with_returned_size)
+{
+  {
+    const size_t n = HUGE_PAGE_SIZE / sizeof(int) + 1;
+    TDynamicVector<int, TCountingAllocator<int>> v(n);
+    pair<int*, size_t> p = v.release();
+    EXPECT_EQ(n, p.second);
+    destroy_n(p.first, p.second);
+    v.get_allocator().deallocate(p.first, p.second);
+    EXPECT_EQ(0, TCountingAllocator<int>::live);
+  }
+  TDynamicVector<double, THugePageAllocator<double>> v(HUGE_PAGE_SIZE / sizeof(double) * 2);
+  v[0] = 1;
+  pair<double*, size_t> p = v.release();
+  ASSERT_EQ(HUGE_PAGE_SIZE / sizeof(double) * 2, p.second);
+  EXPECT_EQ(1, p.first[0]);
+  v.get_allocator().deallocate(p.first, p.second);
+}
+
+TEST(TDynamicVector, cant_release_inline_buffer)
+{
+  TDynamicVector<int> v(2);
+
+  ASSERT_ANY_THROW(v.release());
+}
+
+
@@ -0,0 +1,161 @@
+#include "tmatrix.h"
+
+#include <gtest.h>
+
+TEST(TVectorView, view_refers_to_vector_memory)
+{
+  TDynamicVector<int> v(100);
+  TVectorView<int> s = v.slice(10, 5);
+  s[0] = 7;
+
+  EXPECT_EQ(5u, s.size());
+  EXPECT_EQ(7, v[10]);
+}
+
+TEST(TVectorView, can_take_strided_slice)
+{
+  TDynamicVector<int> v(10);
+  for (size_t i = 0; i < 10; i++)
+    v[i] = int(i);
+  TVectorView<const int> s = static_cast<const TDynamicVector<int>&>(v).slice(1, 3, 3);
+
+  EXPECT_EQ(1, s[0]);
+  EXPECT_EQ(4, s[1]);
+  EXPECT_EQ(7, s[2]);
+}
+
+TEST(TVectorView, throws_when_slice_is_out_of_range)
+{
+  TDynamicVector<int> v(10);
+
+  ASSERT_NO_THROW(v.slice(0, 4, 3));
+  ASSERT_ANY_THROW(v.slice(0, 5, 3));
+  ASSERT_ANY_THROW(v.slice(10, 1));
+  ASSERT_ANY_THROW(v.slice(0, 0));
+}
+
+TEST(TVectorView, throws_when_set_element_with_too_large_index)
+{
+  TDynamicVector<int> v(10);
+  TVectorView<int> s = v.slice(2, 3);
+
+  ASSERT_ANY_THROW(s.at(3) = 1);
+}
+
+TEST(TVectorView, can_add_view_and_vector)
+{
+  TDynamicVector<int> v(6), v1(3);
+  v[4] = 2;
+  v1[2] = 5;
+  TDynamicVector<int> res = v.slice(2, 3) + v1;
+  TDynamicVector<int> res1 = v1 + v.slice(2, 3);
+
+  EXPECT_EQ(7, res[2]);
+  EXPECT_EQ(res, res1);
+}
+
+TEST(TVectorView, can_subtract_views)
+{
+  TDynamicVector<int> v(6);
+  for (size_t i = 0; i < 6; i++)
+    v[i] = int(i);
+  TDynamicVector<int> res = v.slice(3, 3) - v.slice(0, 3);
+
+  EXPECT_EQ(3, res[0]);
+  EXPECT_EQ(3, res[2]);
+}
+
+TEST(TVectorView, can_multiply_views)
+{
+  TDynamicVector<int> v(4);
+  v[0] = 1; v[1] = 2; v[2] = 3; v[3] = 4;
+
+  EXPECT_EQ(1 * 2 + 3 * 4, v.slice(0, 2, 2) * v.slice(1, 2, 2));
+}
+
+TEST(TVectorView, cant_add_views_with_not_equal_size)
+{
+  TDynamicVector<int> v(6);
+
+  ASSERT_ANY_THROW(v.slice(0, 2) + v.slice(0, 3));
+}
+
+TEST(TMatrixView, column_view_walks_rows)
+{
+  TDynamicMatrix<int> m(3, 4);
+  m[0][1] = 1; m[1][1] = 2; m[2][1] = 3;
+  TVectorView<int> c = m.col(1);
+  c[2] = 5;
+
+  EXPECT_EQ(3u, c.size());
+  EXPECT_EQ(2, c[1]);
+  EXPECT_EQ(5, m[2][1]);
+}
+
+TEST(TMatrixView, row_view_is_contiguous)
+{
+  TDynamicMatrix<int> m(3, 4);
+
+  EXPECT_EQ(&m[1][0], &m.row(1)[0]);
+  EXPECT_EQ(4u, m.row(1).size());
+}
+
+TEST(TMatrixView, block_refers_to_matrix_memory)
+{
+  TDynamicMatrix<int> m(4);
+  TMatrixView<int> b = m.block(1, 2, 2, 2);
+  b[1][1] = 9;
+
+  EXPECT_EQ(2u, b.rows());
+  EXPECT_EQ(9, m[2][3]);
+}
+
+TEST(TMatrixView, throws_when_block_is_out_of_range)
+{
+  TDynamicMatrix<int> m(4);
+
+  ASSERT_NO_THROW(m.block(2, 2, 2, 2));
+  ASSERT_ANY_THROW(m.block(2, 2, 3, 2));
+  ASSERT_ANY_THROW(m.block(4, 0, 1, 1));
+}
+
+TEST(TMatrixView, can_add_block_and_matrix)
+{
+  TDynamicMatrix<int> m(3), m1(2);
+  m[1][1] = 2;
+  m1[0][0] = 3;
+  TDynamicMatrix<int> res = m.block(1, 1, 2, 2) + m1;
+  TDynamicMatrix<int> res1 = m1 + m.block(1, 1, 2, 2);
+
+  EXPECT_EQ(5, res[0][0]);
+  EXPECT_EQ(res, res1);
+}
+
+TEST(TMatrixView, can_multiply_block_by_column)
+{
+  TDynamicMatrix<int> m(3);
+  m[0][0] = 1; m[0][1] = 2;
+  m[1][0] = 3; m[1][1] = 4;
+  m[0][2] = 5; m[1][2] = 6;
+  TDynamicVector<int> res = m.block(0, 0, 2, 2) * m.col(2).slice(0, 2);
+
+  EXPECT_EQ(17, res[0]);
+  EXPECT_EQ(39, res[1]);
+}
+
+TEST(TMatrixView, block_product_matches_copied_product)
+{
+  TDynamicMatrix<int> m(4), a(2), b(2);
+  for (size_t i = 0; i < 4; i++)
+    for (size_t j = 0; j < 4; j++)
+      m[i][j] = int(i * 4 + j);
+  for (size_t i = 0; i < 2; i++)
+    for (size_t j = 0; j < 2; j++)
+    {
+      a[i][j] = m[i][j + 2];
+      b[i][j] = m[i + 2][j];
+    }
+
+  EXPECT_EQ(a * b, m.block(0, 2, 2, 2) * m.block(2, 0, 2, 2));
+}
+
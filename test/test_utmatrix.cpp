@@ -0,0 +1,132 @@
+#include "utmatrix.h"
+
+#include <gtest.h>
+
+TEST(TUpperTriangularMatrix, can_create_matrix_with_positive_length)
+{
+  ASSERT_NO_THROW(TUpperTriangularMatrix<int> m(5));
+}
+
+TEST(TUpperTriangularMatrix, cant_create_too_large_matrix)
+{
+  ASSERT_ANY_THROW(TUpperTriangularMatrix<int> m(MAX_MATRIX_SIZE + 1));
+}
+
+TEST(TUpperTriangularMatrix, throws_when_create_matrix_with_negative_length)
+{
+  ASSERT_ANY_THROW(TUpperTriangularMatrix<int> m(-5));
+}
+
+TEST(TUpperTriangularMatrix, can_set_and_get_element)
+{
+  TUpperTriangularMatrix<int> m(4);
+  m[1][3] = 5;
+
+  EXPECT_EQ(5, m[1][3]);
+  EXPECT_EQ(5, m.at(1, 3));
+}
+
+TEST(TUpperTriangularMatrix, elements_are_packed_by_rows)
+{
+  TUpperTriangularMatrix<int> m(3);
+
+  EXPECT_EQ(&m[0][0] + 3, &m[1][1]);
+  EXPECT_EQ(&m[1][1] + 2, &m[2][2]);
+}
+
+TEST(TUpperTriangularMatrix, throws_when_access_element_below_diagonal)
+{
+  TUpperTriangularMatrix<int> m(4);
+
+  ASSERT_ANY_THROW(m.at(2, 1) = 1);
+}
+
+TEST(TUpperTriangularMatrix, throws_when_set_element_with_too_large_index)
+{
+  TUpperTriangularMatrix<int> m(4);
+
+  ASSERT_ANY_THROW(m.at(0, 4) = 1);
+}
+
+TEST(TUpperTriangularMatrix, copied_matrix_has_its_own_memory)
+{
+  TUpperTriangularMatrix<int> m(3);
+  TUpperTriangularMatrix<int> m1(m);
+  m1[0][2] = 4;
+
+  EXPECT_EQ(0, m[0][2]);
+  EXPECT_NE(m, m1);
+}
+
+TEST(TUpperTriangularMatrix, can_add_matrices_with_equal_size)
+{
+  TUpperTriangularMatrix<int> m(2), m1(2);
+  m[0][1] = 1; m1[0][1] = 2; m1[1][1] = 5;
+  TUpperTriangularMatrix<int> res = m + m1;
+
+  EXPECT_EQ(3, res[0][1]);
+  EXPECT_EQ(5, res[1][1]);
+}
+
+TEST(TUpperTriangularMatrix, cant_add_matrices_with_not_equal_size)
+{
+  TUpperTriangularMatrix<int> m(3), m1(4);
+
+  ASSERT_ANY_THROW(m + m1);
+}
+
+TEST(TUpperTriangularMatrix, can_subtract_matrices_with_equal_size)
+{
+  TUpperTriangularMatrix<int> m(2), m1(2);
+  m[0][1] = 1; m1[0][1] = 2;
+  TUpperTriangularMatrix<int> res = m - m1;
+
+  EXPECT_EQ(-1, res[0][1]);
+}
+
+TEST(TUpperTriangularMatrix, can_multiply_matrix_by_scalar)
+{
+  TUpperTriangularMatrix<int> m(2);
+  m[0][1] = 3;
+
+  EXPECT_EQ(6, (m * 2)[0][1]);
+}
+
+TEST(TUpperTriangularMatrix, can_multiply_matrix_by_vector)
+{
+  TUpperTriangularMatrix<int> m(2);
+  m[0][0] = 1; m[0][1] = 2; m[1][1] = 4;
+  TDynamicVector<int> v(2);
+  v[0] = 5; v[1] = 6;
+  TDynamicVector<int> res = m * v;
+
+  EXPECT_EQ(17, res[0]);
+  EXPECT_EQ(24, res[1]);
+}
+
+TEST(TUpperTriangularMatrix, product_matches_dense_product)
+{
+  const size_t n = 5;
+  TUpperTriangularMatrix<int> a(n), b(n);
+  TDynamicMatrix<int> da(n), db(n);
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = i; j < n; j++)
+    {
+      a[i][j] = da[i][j] = int(i * 10 + j);
+      b[i][j] = db[i][j] = int(j - i + 1);
+    }
+  TUpperTriangularMatrix<int> c = a * b;
+  TDynamicMatrix<int> dc = da * db;
+
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = i; j < n; j++)
+      EXPECT_EQ(dc[i][j], c[i][j]);
+}
+
+TEST(TUpperTriangularMatrix, cant_multiply_matrices_with_not_equal_size)
+{
+  TUpperTriangularMatrix<int> m(3), m1(4);
+
+  ASSERT_ANY_THROW(m * m1);
+}
+